@@ -0,0 +1,516 @@
+#ifndef RANDOM_FILL_H
+#define RANDOM_FILL_H
+
+#include <algorithm> // for std::min
+#include <cmath> // for std::abs
+#include <array>
+#include <cassert>
+#include <concepts> // for std::integral, std::floating_point
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t, std::uint64_t, std::int64_t
+#include <limits>
+#include <ranges> // for std::ranges::contiguous_range
+#include <span>
+#include <type_traits> // for std::make_unsigned_t
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define RANDOM_FILL_X86
+	#include <immintrin.h>
+#endif
+
+#include "Random.h"
+
+// Bulk random number generation: Random::fill() fills a whole array with random numbers in one call.
+//
+// Filling a large buffer one Random::get() call at a time is limited by std::mt19937, which produces one 32-bit value
+// at a time.  Random::fill() instead uses 8 independent xoshiro256** generators side by side ("lanes"), so the same
+// few instructions update all 8 at once: with AVX2 that's two 256-bit registers per state word, with SSE2 four 128-bit
+// registers, and otherwise a plain loop that the compiler may vectorize itself.  Which version runs is decided when the
+// program starts, from what the CPU supports.  All three produce exactly the same numbers.
+//
+// xoshiro256** needs a multiplication by 5 and by 9, which AVX2 can't do on 64-bit lanes, but x * 5 == (x << 2) + x
+// and x * 9 == (x << 3) + x, so shifts and adds do the job.  See https://prng.di.unimi.it/ for the generator itself.
+//
+// Sample call: Random::fill(std::span{ values }, 1, 6);  // fills values (e.g. a std::vector<int>) with dice rolls
+// Sample call: Random::fill(samples, 0.0, 1.0);          // fills a std::vector<double> with values in [0, 1)
+// Sample call: Random::fillNormal(samples);              // ... or with values from the standard normal distribution
+namespace Random
+{
+	class BulkGenerator
+	{
+	public:
+		static constexpr std::size_t lanes{ 8 };
+		static constexpr std::size_t blockSize{ 256 }; // 64-bit values generated per refill (a multiple of lanes)
+
+	private:
+		// m_state[k][lane] is word k of that lane's generator, so each word of all 8 lanes is contiguous in memory
+		alignas(64) std::uint64_t m_state[4][lanes]{};
+		alignas(64) std::array<std::uint64_t, blockSize> m_block{};
+
+		static std::uint64_t rotl(std::uint64_t x, int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+		static std::uint64_t splitMix64(std::uint64_t& x)
+		{
+			std::uint64_t z{ (x += 0x9E3779B97F4A7C15) };
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+			return z ^ (z >> 31);
+		}
+
+		// Advances one lane by 2^128 steps, so the lanes' sequences can never overlap
+		void jump(std::size_t lane)
+		{
+			constexpr std::uint64_t jumpPolynomial[]{ 0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA, 0x39ABDC4529B1661C };
+
+			std::uint64_t s[4]{};
+			for (std::uint64_t word : jumpPolynomial)
+			{
+				for (int bit{ 0 }; bit < 64; ++bit)
+				{
+					if (word & (std::uint64_t{ 1 } << bit))
+					{
+						for (std::size_t k{ 0 }; k < 4; ++k)
+							s[k] ^= m_state[k][lane];
+					}
+					stepLane(lane);
+				}
+			}
+
+			for (std::size_t k{ 0 }; k < 4; ++k)
+				m_state[k][lane] = s[k];
+		}
+
+		std::uint64_t stepLane(std::size_t lane)
+		{
+			auto& s{ m_state };
+			std::uint64_t result{ rotl(s[1][lane] * 5, 7) * 9 };
+			std::uint64_t t{ s[1][lane] << 17 };
+			s[2][lane] ^= s[0][lane];
+			s[3][lane] ^= s[1][lane];
+			s[1][lane] ^= s[2][lane];
+			s[0][lane] ^= s[3][lane];
+			s[2][lane] ^= t;
+			s[3][lane] = rotl(s[3][lane], 45);
+			return result;
+		}
+
+		static void refillScalar(BulkGenerator& g)
+		{
+			for (std::size_t i{ 0 }; i < blockSize; i += lanes)
+			{
+				for (std::size_t lane{ 0 }; lane < lanes; ++lane)
+					g.m_block[i + lane] = g.stepLane(lane);
+			}
+		}
+
+#ifdef RANDOM_FILL_X86
+		// x86-64 always has SSE2, but 32-bit x86 might not, so this gets a target attribute too
+		[[gnu::target("sse2")]] static void refillSse2(BulkGenerator& g)
+		{
+			constexpr std::size_t vectors{ lanes / 2 };
+			__m128i s0[vectors], s1[vectors], s2[vectors], s3[vectors];
+			for (std::size_t v{ 0 }; v < vectors; ++v)
+			{
+				s0[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(&g.m_state[0][v * 2]));
+				s1[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(&g.m_state[1][v * 2]));
+				s2[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(&g.m_state[2][v * 2]));
+				s3[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(&g.m_state[3][v * 2]));
+			}
+
+			for (std::size_t i{ 0 }; i < blockSize; i += lanes)
+			{
+				for (std::size_t v{ 0 }; v < vectors; ++v)
+				{
+					__m128i times5{ _mm_add_epi64(_mm_slli_epi64(s1[v], 2), s1[v]) };
+					__m128i rotated{ _mm_or_si128(_mm_slli_epi64(times5, 7), _mm_srli_epi64(times5, 57)) };
+					__m128i result{ _mm_add_epi64(_mm_slli_epi64(rotated, 3), rotated) };
+					_mm_store_si128(reinterpret_cast<__m128i*>(&g.m_block[i + v * 2]), result);
+
+					__m128i t{ _mm_slli_epi64(s1[v], 17) };
+					s2[v] = _mm_xor_si128(s2[v], s0[v]);
+					s3[v] = _mm_xor_si128(s3[v], s1[v]);
+					s1[v] = _mm_xor_si128(s1[v], s2[v]);
+					s0[v] = _mm_xor_si128(s0[v], s3[v]);
+					s2[v] = _mm_xor_si128(s2[v], t);
+					s3[v] = _mm_or_si128(_mm_slli_epi64(s3[v], 45), _mm_srli_epi64(s3[v], 19));
+				}
+			}
+
+			for (std::size_t v{ 0 }; v < vectors; ++v)
+			{
+				_mm_store_si128(reinterpret_cast<__m128i*>(&g.m_state[0][v * 2]), s0[v]);
+				_mm_store_si128(reinterpret_cast<__m128i*>(&g.m_state[1][v * 2]), s1[v]);
+				_mm_store_si128(reinterpret_cast<__m128i*>(&g.m_state[2][v * 2]), s2[v]);
+				_mm_store_si128(reinterpret_cast<__m128i*>(&g.m_state[3][v * 2]), s3[v]);
+			}
+		}
+
+		[[gnu::target("avx2")]] static void refillAvx2(BulkGenerator& g)
+		{
+			constexpr std::size_t vectors{ lanes / 4 };
+			__m256i s0[vectors], s1[vectors], s2[vectors], s3[vectors];
+			for (std::size_t v{ 0 }; v < vectors; ++v)
+			{
+				s0[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&g.m_state[0][v * 4]));
+				s1[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&g.m_state[1][v * 4]));
+				s2[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&g.m_state[2][v * 4]));
+				s3[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&g.m_state[3][v * 4]));
+			}
+
+			for (std::size_t i{ 0 }; i < blockSize; i += lanes)
+			{
+				for (std::size_t v{ 0 }; v < vectors; ++v)
+				{
+					__m256i times5{ _mm256_add_epi64(_mm256_slli_epi64(s1[v], 2), s1[v]) };
+					__m256i rotated{ _mm256_or_si256(_mm256_slli_epi64(times5, 7), _mm256_srli_epi64(times5, 57)) };
+					__m256i result{ _mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated) };
+					_mm256_store_si256(reinterpret_cast<__m256i*>(&g.m_block[i + v * 4]), result);
+
+					__m256i t{ _mm256_slli_epi64(s1[v], 17) };
+					s2[v] = _mm256_xor_si256(s2[v], s0[v]);
+					s3[v] = _mm256_xor_si256(s3[v], s1[v]);
+					s1[v] = _mm256_xor_si256(s1[v], s2[v]);
+					s0[v] = _mm256_xor_si256(s0[v], s3[v]);
+					s2[v] = _mm256_xor_si256(s2[v], t);
+					s3[v] = _mm256_or_si256(_mm256_slli_epi64(s3[v], 45), _mm256_srli_epi64(s3[v], 19));
+				}
+			}
+
+			for (std::size_t v{ 0 }; v < vectors; ++v)
+			{
+				_mm256_store_si256(reinterpret_cast<__m256i*>(&g.m_state[0][v * 4]), s0[v]);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(&g.m_state[1][v * 4]), s1[v]);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(&g.m_state[2][v * 4]), s2[v]);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(&g.m_state[3][v * 4]), s3[v]);
+			}
+		}
+#endif
+
+	public:
+		enum class Isa
+		{
+			scalar,
+			sse2,
+			avx2,
+		};
+
+		// The best version this CPU can run (checked once, the first time it is needed)
+		static Isa isa()
+		{
+#ifdef RANDOM_FILL_X86
+			static const Isa s_isa{ __builtin_cpu_supports("avx2") ? Isa::avx2
+				: __builtin_cpu_supports("sse2") ? Isa::sse2 : Isa::scalar };
+			return s_isa;
+#else
+			return Isa::scalar;
+#endif
+		}
+
+		explicit BulkGenerator(std::uint64_t seed)
+		{
+			// Lane 0 is seeded with SplitMix64 (as the xoshiro authors recommend), and each lane after that starts 2^128
+			// steps further along the same sequence
+			for (std::size_t k{ 0 }; k < 4; ++k)
+				m_state[k][0] = splitMix64(seed);
+
+			for (std::size_t lane{ 1 }; lane < lanes; ++lane)
+			{
+				for (std::size_t k{ 0 }; k < 4; ++k)
+					m_state[k][lane] = m_state[k][lane - 1];
+				jump(lane);
+			}
+		}
+
+		// Generates the next blockSize values; use block() to read them
+		void refill(Isa use = isa())
+		{
+			switch (use)
+			{
+#ifdef RANDOM_FILL_X86
+			case Isa::avx2: refillAvx2(*this); break;
+			case Isa::sse2: refillSse2(*this); break;
+#endif
+			default:        refillScalar(*this); break;
+			}
+		}
+
+		const std::array<std::uint64_t, blockSize>& block() const { return m_block; }
+
+		// BulkGenerator can also be used one value at a time, like any other random number generator.  These values
+		// come straight from lane 0 (moving it along, so they never repeat anything in a block), and don't touch
+		// block(), so they can be used to patch up the odd value while a block is still being read.
+		using result_type = std::uint64_t;
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+		result_type operator()()
+		{
+			return stepLane(0);
+		}
+	};
+
+	// Each thread gets its own bulk generator, seeded from Random::mt the first time that thread calls fill().  Like
+	// Random::mt, it is reseeded in the child after a fork() (from the child's Random::mt, which has a stream of its
+	// own by then), so that children don't all fill their arrays with the same numbers.
+	inline BulkGenerator& bulkGenerator()
+	{
+		struct State
+		{
+			BulkGenerator generator;
+			unsigned int generation{};
+			std::uint64_t lineage{};
+		};
+
+		// generator comes first, so the generation is read after Random::mt has caught up with any fork
+		thread_local State s_state{ BulkGenerator{ detail::next64(mt) },
+			detail::forkGeneration.load(std::memory_order_relaxed), detail::lineage };
+
+		if (s_state.generation != detail::forkGeneration.load(std::memory_order_relaxed)
+			|| s_state.lineage != detail::lineage) [[unlikely]]
+		{
+			s_state.generator = BulkGenerator{ detail::next64(mt) };
+			s_state.generation = detail::forkGeneration.load(std::memory_order_relaxed);
+			s_state.lineage = detail::lineage;
+		}
+
+		return s_state.generator;
+	}
+
+	// Fills values with random integers between [min, max] (inclusive)
+	template <std::integral T>
+	void fill(std::span<T> values, T min, T max)
+	{
+		using U = std::make_unsigned_t<T>;
+		auto range{ static_cast<U>(static_cast<U>(max) - static_cast<U>(min)) };
+		BulkGenerator& g{ bulkGenerator() };
+
+		if (range > std::numeric_limits<std::uint32_t>::max())
+		{
+			// Rare enough (ranges wider than 4 billion) that we don't bother with a fast path
+			for (T& v : values)
+				v = static_cast<T>(static_cast<U>(min) + static_cast<U>(detail::uniform<std::uint64_t>(g, 0, range)));
+			return;
+		}
+
+		// The same method as Random::get, using each 64-bit random value as two 32-bit ones.  The threshold below
+		// which a result would be biased only depends on the range, so it is worked out once here, not per value.
+		std::uint64_t s{ static_cast<std::uint64_t>(range) + 1 };
+		auto threshold{ static_cast<std::uint32_t>(((std::uint64_t{ 1 } << 32) - s) % s) };
+
+		std::size_t done{ 0 };
+		while (done < values.size())
+		{
+			g.refill();
+			const auto& block{ g.block() };
+
+			std::size_t count{ std::min(values.size() - done, BulkGenerator::blockSize * 2) };
+			T* out{ values.data() + done };
+
+			// Value i comes from the low (even i) or high (odd i) half of block[i / 2]
+			auto half{ [&block](std::size_t i) { return static_cast<std::uint32_t>(block[i / 2] >> (i % 2 * 32)); } };
+
+			// First pass: no branches, so the compiler can vectorize it
+			std::uint32_t lowest{ std::numeric_limits<std::uint32_t>::max() };
+			for (std::size_t i{ 0 }; i + 1 < count; i += 2)
+			{
+				std::uint64_t m0{ static_cast<std::uint32_t>(block[i / 2]) * s };
+				std::uint64_t m1{ static_cast<std::uint32_t>(block[i / 2] >> 32) * s };
+				lowest = std::min(lowest, std::min(static_cast<std::uint32_t>(m0), static_cast<std::uint32_t>(m1)));
+				out[i] = static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(m0 >> 32)));
+				out[i + 1] = static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(m1 >> 32)));
+			}
+			if (count % 2 == 1)
+			{
+				std::uint64_t m{ half(count - 1) * s };
+				lowest = std::min(lowest, static_cast<std::uint32_t>(m));
+				out[count - 1] = static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(m >> 32)));
+			}
+
+			// Second pass, almost never needed: redraw any value that could have been biased
+			if (lowest < threshold)
+			{
+				for (std::size_t i{ 0 }; i < count; ++i)
+				{
+					if (static_cast<std::uint32_t>(half(i) * s) < threshold)
+						out[i] = static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(detail::bounded32(g, static_cast<std::uint32_t>(range)))));
+				}
+			}
+
+			done += count;
+		}
+	}
+
+	// Fills values with random floating point numbers between [min, max).  (Rounding in min + x * (max - min) can
+	// occasionally give max itself.)
+	template <std::floating_point T>
+	void fill(std::span<T> values, T min, T max)
+	{
+		BulkGenerator& g{ bulkGenerator() };
+		T scale{ max - min };
+
+		std::size_t done{ 0 };
+		while (done < values.size())
+		{
+			g.refill();
+			const auto& block{ g.block() };
+			T* out{ values.data() + done };
+
+			if constexpr (sizeof(T) <= sizeof(float))
+			{
+				// 24 random bits (a float's precision) from each half of a 64-bit value
+				std::size_t count{ std::min(values.size() - done, BulkGenerator::blockSize * 2) };
+				for (std::size_t i{ 0 }; i < count; ++i)
+				{
+					auto bits{ static_cast<std::uint32_t>(block[i / 2] >> (i % 2 * 32)) >> 8 };
+					out[i] = min + static_cast<T>(static_cast<float>(bits) * 0x1.0p-24f) * scale;
+				}
+				done += count;
+			}
+			else
+			{
+				// 53 random bits (a double's precision) from each 64-bit value
+				std::size_t count{ std::min(values.size() - done, BulkGenerator::blockSize) };
+				for (std::size_t i{ 0 }; i < count; ++i)
+					out[i] = min + static_cast<T>(static_cast<double>(block[i] >> 11) * 0x1.0p-53) * scale;
+				done += count;
+			}
+		}
+	}
+
+	// So a std::vector or std::array can be passed without wrapping it in a std::span first
+	template <std::ranges::contiguous_range R, typename T>
+		requires (!std::same_as<std::remove_cvref_t<R>, std::span<std::ranges::range_value_t<R>>>)
+	void fill(R&& values, T min, T max)
+	{
+		fill(std::span<std::ranges::range_value_t<R>>{ values }, static_cast<std::ranges::range_value_t<R>>(min),
+			static_cast<std::ranges::range_value_t<R>>(max));
+	}
+
+	// Fills indices with random indices drawn from table (see AliasTable in Random.h)
+	// Sample call: Random::fill(std::span{ monsterTypes }, spawnRates);
+	template <std::integral T>
+	void fill(std::span<T> indices, const AliasTable& table)
+	{
+		assert(table.size() > 0 && "Can't draw from an empty AliasTable");
+
+		BulkGenerator& g{ bulkGenerator() };
+		const AliasTable::Column* columns{ table.columns().data() };
+		auto n{ static_cast<std::uint64_t>(table.size()) };
+		auto threshold{ static_cast<std::uint32_t>(((std::uint64_t{ 1 } << 32) - n) % n) };
+
+		std::size_t done{ 0 };
+		while (done < indices.size())
+		{
+			g.refill();
+			const auto& block{ g.block() };
+
+			std::size_t count{ std::min(indices.size() - done, BulkGenerator::blockSize) };
+			T* out{ indices.data() + done };
+
+			// The top half of each 64-bit value picks the column (as in fill() above), and the bottom half is the coin.
+			// No branches here, so the coin tosses (which are unpredictable) don't cost a branch misprediction each.
+			std::uint32_t lowest{ std::numeric_limits<std::uint32_t>::max() };
+			for (std::size_t i{ 0 }; i < count; ++i)
+			{
+				std::uint64_t m{ (block[i] >> 32) * n };
+				auto column{ static_cast<std::uint32_t>(m >> 32) };
+				lowest = std::min(lowest, static_cast<std::uint32_t>(m));
+
+				AliasTable::Column c{ columns[column] };
+				out[i] = static_cast<T>((static_cast<std::uint32_t>(block[i]) < c.threshold) ? column : c.alias);
+			}
+
+			// Almost never needed: redraw any index whose column could have been biased
+			if (lowest < threshold)
+			{
+				for (std::size_t i{ 0 }; i < count; ++i)
+				{
+					if (static_cast<std::uint32_t>((block[i] >> 32) * n) < threshold)
+						out[i] = static_cast<T>(table(g));
+				}
+			}
+
+			done += count;
+		}
+	}
+
+	template <std::ranges::contiguous_range R>
+		requires (!std::same_as<std::remove_cvref_t<R>, std::span<std::ranges::range_value_t<R>>>)
+	void fill(R&& indices, const AliasTable& table)
+	{
+		fill(std::span<std::ranges::range_value_t<R>>{ indices }, table);
+	}
+
+	// Fills values with random numbers in [0, 1), like Random::uniform01()
+	template <std::floating_point T>
+	void fillUniform01(std::span<T> values)
+	{
+		BulkGenerator& g{ bulkGenerator() };
+
+		std::size_t done{ 0 };
+		while (done < values.size())
+		{
+			g.refill();
+			const auto& block{ g.block() };
+
+			std::size_t count{ std::min(values.size() - done, BulkGenerator::blockSize) };
+			T* out{ values.data() + done };
+			for (std::size_t i{ 0 }; i < count; ++i)
+				out[i] = static_cast<T>(static_cast<double>(block[i] >> 11) * 0x1.0p-53);
+			done += count;
+		}
+	}
+
+	// Fills values with normally distributed random numbers, like Random::normal()
+	// Sample call: Random::fillNormal(std::span{ heights }, 100.0, 0.5);
+	template <std::floating_point T>
+	void fillNormal(std::span<T> values, T mean = 0, T stddev = 1)
+	{
+		BulkGenerator& g{ bulkGenerator() };
+		const detail::Ziggurat& z{ detail::ziggurat() };
+
+		std::size_t done{ 0 };
+		while (done < values.size())
+		{
+			g.refill();
+			const auto& block{ g.block() };
+
+			std::size_t count{ std::min(values.size() - done, BulkGenerator::blockSize) };
+			T* out{ values.data() + done };
+			for (std::size_t i{ 0 }; i < count; ++i)
+			{
+				// The ziggurat's fast path from detail::normal(), written out here so the common case has no call
+				std::uint64_t bits{ block[i] };
+				auto layer{ static_cast<std::size_t>(bits & (detail::Ziggurat::layers - 1)) };
+				double u{ static_cast<double>(static_cast<std::int64_t>(bits) >> 11) * 0x1.0p-52 };
+
+				double x{ (std::abs(u) < z.ratio[layer]) ? u * z.x[layer] : detail::normal(bits, g) };
+				out[i] = mean + stddev * static_cast<T>(x);
+			}
+			done += count;
+		}
+	}
+
+	// So a std::vector or std::array can be passed without wrapping it in a std::span first
+	template <std::ranges::contiguous_range R>
+		requires (!std::same_as<std::remove_cvref_t<R>, std::span<std::ranges::range_value_t<R>>>)
+	void fillUniform01(R&& values)
+	{
+		fillUniform01(std::span<std::ranges::range_value_t<R>>{ values });
+	}
+
+	template <std::ranges::contiguous_range R, typename T = std::ranges::range_value_t<R>>
+		requires (!std::same_as<std::remove_cvref_t<R>, std::span<std::ranges::range_value_t<R>>>)
+	void fillNormal(R&& values, T mean = 0, T stddev = 1)
+	{
+		fillNormal(std::span<std::ranges::range_value_t<R>>{ values }, static_cast<std::ranges::range_value_t<R>>(mean),
+			static_cast<std::ranges::range_value_t<R>>(stddev));
+	}
+}
+
+#undef RANDOM_FILL_X86
+
+#endif
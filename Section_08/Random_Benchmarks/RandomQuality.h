@@ -0,0 +1,499 @@
+#ifndef RANDOM_QUALITY_H
+#define RANDOM_QUALITY_H
+
+#include <algorithm> // for std::min, std::max
+#include <array>
+#include <bit> // for std::bit_width
+#include <cmath> // for std::erfc, std::cbrt, std::sqrt, std::abs
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <iomanip> // for std::setw, std::setprecision
+#include <iostream>
+#include <limits>
+#include <numeric> // for std::iota
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <sys/wait.h> // for waitpid
+	#include <unistd.h> // for fork, pipe, read, write, _exit
+#endif
+
+#include "Random.h"
+#include "RandomFill.h"
+
+// Quick statistical sanity checks for the generators and distributions in Random.h.
+//
+// A faster generator is only worth having if the simulations built on it still give the right answers, so each engine
+// is put through a few cheap tests.  None of them prove a generator is good (TestU01 and PractRand exist for that),
+// but they do catch the mistakes that would skew a simulation: a biased range reduction, a broken shuffle, a normal
+// distribution with the wrong shape, or low bits that aren't random.
+//
+// Each test turns its counts into a p-value, the chance that a perfect generator would do at least this badly.  A
+// p-value that is tiny means the counts are too far from what we expected, and one very close to 1 means they are
+// suspiciously close (real randomness is lumpier than that), so either end counts as a failure.
+namespace Quality
+{
+	// Small enough that a run of a few dozen checks essentially never fails by chance
+	constexpr double alpha { 1e-6 };
+
+	struct Check
+	{
+		std::string engine {};
+		std::string name {};
+		double statistic {};
+		double pValue {};
+
+		bool passed() const { return pValue > alpha && pValue < 1.0 - alpha; }
+	};
+
+	// The probability that a chi-square variable with the given degrees of freedom is at least chi2.
+	// Uses the Wilson-Hilferty approximation (the cube root of chi2 / degrees is very nearly normal), which is plenty
+	// accurate for deciding whether something is wildly off.
+	inline double chiSquarePValue(double chi2, double degrees)
+	{
+		double variance { 2.0 / (9.0 * degrees) };
+		double z { (std::cbrt(chi2 / degrees) - (1.0 - variance)) / std::sqrt(variance) };
+		return 0.5 * std::erfc(z / std::sqrt(2.0));
+	}
+
+	// Pearson's chi-square statistic for counts that should all be equal
+	inline double chiSquare(std::span<const std::uint64_t> counts)
+	{
+		std::uint64_t total { 0 };
+		for (std::uint64_t c : counts)
+			total += c;
+
+		double expected { static_cast<double>(total) / static_cast<double>(counts.size()) };
+		double chi2 { 0.0 };
+		for (std::uint64_t c : counts)
+		{
+			double difference { static_cast<double>(c) - expected };
+			chi2 += difference * difference / expected;
+		}
+		return chi2;
+	}
+
+	inline Check chiSquareCheck(std::string_view engine, std::string_view name, std::span<const std::uint64_t> counts)
+	{
+		double chi2 { chiSquare(counts) };
+		return { std::string { engine }, std::string { name }, chi2, chiSquarePValue(chi2, static_cast<double>(counts.size() - 1)) };
+	}
+
+	// The top and bottom 8 bits of each of count values of the given width (from next()), each counted into 256
+	// buckets.  Weak generators (e.g. an LCG with a power of two modulus) often get the top bits right and the bottom
+	// ones badly wrong.
+	template <typename Next>
+	void checkBytesFrom(std::vector<Check>& checks, std::string_view name, Next next, int bits, std::size_t count)
+	{
+		std::array<std::uint64_t, 256> high {};
+		std::array<std::uint64_t, 256> low {};
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			auto value { static_cast<std::uint64_t>(next()) };
+			++high[value >> (bits - 8)];
+			++low[value & 0xFF];
+		}
+
+		checks.push_back(chiSquareCheck(name, "top byte chi2", high));
+		checks.push_back(chiSquareCheck(name, "low byte chi2", low));
+	}
+
+	// ... of the raw output of engine
+	template <typename Engine>
+	void checkBytes(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		checkBytesFrom(checks, name, [&engine] { return engine(); }, std::bit_width(Engine::max()), count);
+	}
+
+	// Whether each of count values in [0, 1) (from next()) predicts the one after it (the lag 1 serial correlation
+	// from Knuth, TAOCP 3.3.2).  For independent values it is about 0, give or take 1 / sqrt(count).
+	template <typename Next>
+	void checkSerialCorrelationFrom(std::vector<Check>& checks, std::string_view name, Next next, std::size_t count)
+	{
+		double first { next() };
+		double previous { first };
+		double sum { first };
+		double sumSquares { first * first };
+		double sumProducts { 0.0 };
+		for (std::size_t i { 1 }; i < count; ++i)
+		{
+			double u { next() };
+			sum += u;
+			sumSquares += u * u;
+			sumProducts += previous * u;
+			previous = u;
+		}
+		sumProducts += previous * first; // wrap around, as Knuth does
+
+		auto n { static_cast<double>(count) };
+		double r { (n * sumProducts - sum * sum) / (n * sumSquares - sum * sum) };
+		double z { r * std::sqrt(n) };
+		checks.push_back({ std::string { name }, "serial correlation", r, std::erfc(std::abs(z) / std::sqrt(2.0)) });
+	}
+
+	// ... of Random::uniform01() values from engine
+	template <typename Engine>
+	void checkSerialCorrelation(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		checkSerialCorrelationFrom(checks, name, [&engine] { return Random::uniform01(engine); }, count);
+	}
+
+	// count values in [0, 1) (from next()), counted into 64 equal buckets
+	template <typename Next>
+	void checkUniform01From(std::vector<Check>& checks, std::string_view name, Next next, std::size_t count)
+	{
+		std::array<std::uint64_t, 64> counts {};
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			auto bucket { static_cast<std::size_t>(next() * static_cast<double>(counts.size())) };
+			++counts[std::min(bucket, counts.size() - 1)];
+		}
+
+		checks.push_back(chiSquareCheck(name, "uniform01 chi2", counts));
+	}
+
+	// ... of Random::uniform01() values from engine
+	template <typename Engine>
+	void checkUniform01(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		checkUniform01From(checks, name, [&engine] { return Random::uniform01(engine); }, count);
+	}
+
+	// count values that should be normally distributed (from next()), counted into 64 buckets that a standard normal
+	// distribution fills equally
+	template <typename Next>
+	void checkNormalFrom(std::vector<Check>& checks, std::string_view name, Next next, std::size_t count)
+	{
+		std::array<std::uint64_t, 64> counts {};
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			double cdf { 0.5 * std::erfc(-next() / std::sqrt(2.0)) };
+			auto bucket { static_cast<std::size_t>(cdf * static_cast<double>(counts.size())) };
+			++counts[std::min(bucket, counts.size() - 1)];
+		}
+
+		checks.push_back(chiSquareCheck(name, "normal chi2", counts));
+	}
+
+	// ... of Random::normal() values from engine
+	template <typename Engine>
+	void checkNormal(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		checkNormalFrom(checks, name, [&engine] { return Random::normal(engine); }, count);
+	}
+
+	// Where the first card of a deck ends up after Random::shuffle(), which should be any of the 52 places equally
+	template <typename Engine>
+	void checkShuffle(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		std::array<int, 52> deck {};
+		std::array<std::uint64_t, 52> counts {};
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			std::iota(deck.begin(), deck.end(), 0);
+			Random::shuffle(deck, engine);
+			for (std::size_t place { 0 }; place < deck.size(); ++place)
+			{
+				if (deck[place] == 0)
+					++counts[place];
+			}
+		}
+
+		checks.push_back(chiSquareCheck(name, "shuffle chi2", counts));
+	}
+
+	// Which index each of count draws from an AliasTable picked, against what its weights say they should be.  The
+	// weights are uneven, so that both sides of the columns' coin tosses get used.
+	constexpr std::array<double, 8> aliasWeights { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 };
+
+	inline Check aliasCheck(std::string_view name, std::span<const std::uint64_t> counts)
+	{
+		std::uint64_t total { 0 };
+		for (std::uint64_t c : counts)
+			total += c;
+
+		double weightTotal { 0.0 };
+		for (double w : aliasWeights)
+			weightTotal += w;
+
+		double chi2 { 0.0 };
+		for (std::size_t i { 0 }; i < counts.size(); ++i)
+		{
+			double expected { static_cast<double>(total) * aliasWeights[i] / weightTotal };
+			double difference { static_cast<double>(counts[i]) - expected };
+			chi2 += difference * difference / expected;
+		}
+		return { std::string { name }, "alias table chi2", chi2, chiSquarePValue(chi2, static_cast<double>(counts.size() - 1)) };
+	}
+
+	template <typename Engine>
+	void checkAliasTable(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		Random::AliasTable table { aliasWeights };
+		std::array<std::uint64_t, aliasWeights.size()> counts {};
+		for (std::size_t i { 0 }; i < count; ++i)
+			++counts[table(engine)];
+
+		checks.push_back(aliasCheck(name, counts));
+	}
+
+	// Which of 64 items a ReservoirSampler keeps in a sample of 4 (skipping the items it says it doesn't need), over
+	// count samples.  Every item should be kept equally often.
+	template <typename Engine>
+	void checkReservoir(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count)
+	{
+		std::array<std::uint64_t, 64> counts {};
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			Random::ReservoirSampler<std::size_t> sampler { 4 };
+			for (std::size_t item { 0 }; item < counts.size(); ++item)
+			{
+				if (sampler.skipAhead() > 0)
+					sampler.skip(1);
+				else
+					sampler.add(item, engine);
+			}
+
+			for (std::size_t item : sampler.sample())
+				++counts[item];
+		}
+
+		checks.push_back(chiSquareCheck(name, "reservoir chi2", counts));
+	}
+
+	// The die roll histogram from lesson 8.14, but with a million rolls, so each bar is scaled to at most 50 '*'s
+	template <typename Engine>
+	void checkDie(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count, std::ostream& out)
+	{
+		std::array<std::uint64_t, 6> rolls {};
+		for (std::size_t i { 0 }; i < count; ++i)
+			++rolls[static_cast<std::size_t>(Random::get(engine, 1, 6) - 1)];
+
+		checks.push_back(chiSquareCheck(name, "die roll chi2", rolls));
+
+		std::uint64_t most { 0 };
+		for (std::uint64_t r : rolls)
+			most = std::max(most, r);
+
+		out << "== " << name << " HISTOGRAM DISTRIBUTION ==\n";
+		for (std::size_t face { 0 }; face < rolls.size(); ++face)
+		{
+			out << face + 1 << " | " << std::string(static_cast<std::size_t>(rolls[face] * 50 / most), '*') << ' ' << rolls[face] << '\n';
+		}
+	}
+
+	// Runs every check on one engine
+	template <typename Engine>
+	void checkEngine(std::vector<Check>& checks, std::string_view name, Engine& engine, std::size_t count, std::ostream& out)
+	{
+		checkBytes(checks, name, engine, count);
+		checkSerialCorrelation(checks, name, engine, count);
+		checkUniform01(checks, name, engine, count);
+		checkNormal(checks, name, engine, count);
+		checkShuffle(checks, name, engine, count / 64);
+		checkAliasTable(checks, name, engine, count);
+		checkReservoir(checks, name, engine, count / 256);
+		checkDie(checks, name, engine, count, out);
+	}
+
+	// Returns a function that reads the values of buffer one after another, for the checks above
+	template <typename T>
+	auto reader(const std::vector<T>& buffer)
+	{
+		return [&buffer, i = std::size_t { 0 }]() mutable { return buffer[i++]; };
+	}
+
+	// The checks above, on buffers filled by Random::fill(), fillUniform01() and fillNormal().  These read whole
+	// blocks from BulkGenerator (generated by its SSE2 or AVX2 code, where the CPU has them), which checkEngine()
+	// doesn't: used as an engine, BulkGenerator only steps its first lane, one value at a time.
+	inline void checkFill(std::vector<Check>& checks, std::size_t count)
+	{
+		// [0, 2^32 - 1] is the full range of a 32-bit value, so these are the generator's bits as they are
+		std::vector<std::uint32_t> bits(count);
+		Random::fill(bits, std::uint32_t { 0 }, std::numeric_limits<std::uint32_t>::max());
+		checkBytesFrom(checks, "fill uint32", reader(bits), 32, count);
+
+		std::vector<double> uniform(count);
+		Random::fillUniform01(uniform);
+		checkSerialCorrelationFrom(checks, "fillUniform01", reader(uniform), count);
+		checkUniform01From(checks, "fillUniform01", reader(uniform), count);
+
+		Random::fill(uniform, 0.0, 1.0);
+		checkSerialCorrelationFrom(checks, "fill double", reader(uniform), count);
+
+		std::vector<double> normal(count);
+		Random::fillNormal(normal);
+		checkNormalFrom(checks, "fillNormal", reader(normal), count);
+
+		std::vector<int> rolls(count);
+		Random::fill(rolls, 1, 6);
+		std::array<std::uint64_t, 6> faces {};
+		for (int roll : rolls)
+			++faces[static_cast<std::size_t>(roll - 1)];
+		checks.push_back(chiSquareCheck("fill [1, 6]", "die roll chi2", faces));
+
+		std::vector<int> indices(count);
+		Random::fill(std::span { indices }, Random::AliasTable { aliasWeights });
+		std::array<std::uint64_t, aliasWeights.size()> picks {};
+		for (int index : indices)
+			++picks[static_cast<std::size_t>(index)];
+		checks.push_back(aliasCheck("fill alias", picks));
+	}
+
+	// Refills BulkGenerators with the same seed using each instruction set the CPU supports, and checks that they all
+	// generate exactly the same blocks as the plain C++ version.  Returns true if they do.
+	inline bool checkBulkIsas(std::ostream& out)
+	{
+		using Isa = Random::BulkGenerator::Isa;
+		constexpr std::string_view names[] { "scalar", "sse2", "avx2" };
+		constexpr int refills { 64 };
+
+		bool passed { true };
+		std::string tested { names[0] };
+		for (Isa isa : { Isa::sse2, Isa::avx2 })
+		{
+			if (isa > Random::BulkGenerator::isa())
+				break;
+
+			Random::BulkGenerator reference { Random::masterSeed() };
+			Random::BulkGenerator vector { Random::masterSeed() };
+			for (int i { 0 }; i < refills; ++i)
+			{
+				reference.refill(Isa::scalar);
+				vector.refill(isa);
+				if (reference.block() != vector.block())
+					passed = false;
+			}
+			tested += ", " + std::string { names[static_cast<int>(isa)] };
+		}
+
+		out << "bulk refill check: " << tested << (passed ? " give the same values  ok\n" : " give DIFFERENT values  FAIL\n");
+		return passed;
+	}
+
+	// Forks children, and checks that each one draws different numbers from Random::mt and Random::fill() than the
+	// others (and than the parent).  Half the children are forked before the parent has used Random at all, and half
+	// after it has drawn numbers from both, so run this before anything else uses Random.  (Run it with LEARNCPP_SEED
+	// set too: with a random seed, children that choose their own seed differ anyway.)  Returns true if it passed (or
+	// fork() isn't available).
+	inline bool checkForkedChildren(std::ostream& out)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		constexpr int children { 4 };
+		constexpr std::size_t draws { 4 };
+		using Draws = std::array<std::uint64_t, draws>;
+		struct Numbers
+		{
+			Draws fromMt {};
+			Draws fromFill {};
+		};
+
+		auto draw { [] {
+			Numbers n {};
+			for (std::uint64_t& v : n.fromMt)
+				v = Random::get(std::uint64_t { 0 }, std::uint64_t { 999'999 });
+			Random::fill(std::span { n.fromFill }, std::uint64_t { 0 }, std::uint64_t { 999'999 });
+			return n;
+		} };
+
+		std::vector<Numbers> seen {};
+		auto forkChild { [&seen, &draw] {
+			int fds[2] {};
+			if (pipe(fds) != 0)
+				return;
+
+			pid_t pid { fork() };
+			if (pid < 0)
+				return;
+			if (pid == 0)
+			{
+				Numbers n { draw() };
+				bool written { write(fds[1], &n, sizeof(n)) == static_cast<ssize_t>(sizeof(n)) };
+				_exit(written ? 0 : 1);
+			}
+
+			close(fds[1]);
+			Numbers n {};
+			bool received { read(fds[0], &n, sizeof(n)) == static_cast<ssize_t>(sizeof(n)) };
+			close(fds[0]);
+			waitpid(pid, nullptr, 0);
+			if (received)
+				seen.push_back(n);
+		} };
+
+		for (int i { 0 }; i < children / 2; ++i)
+			forkChild();
+		seen.push_back(draw());
+		for (int i { 0 }; i < children / 2; ++i)
+			forkChild();
+
+		bool passed { seen.size() == children + 1 };
+		for (std::size_t i { 0 }; i < seen.size(); ++i)
+		{
+			for (std::size_t j { i + 1 }; j < seen.size(); ++j)
+			{
+				if (seen[i].fromMt == seen[j].fromMt || seen[i].fromFill == seen[j].fromFill)
+					passed = false;
+			}
+		}
+
+		out << "fork check: " << children << " children and their parent drew " << (passed ? "different" : "THE SAME")
+			<< " numbers" << (passed ? "  ok\n" : "  FAIL\n");
+		return passed;
+#else
+		(void)out;
+		return true;
+#endif
+	}
+
+	// Offers a ReservoirSampler a stream of items (skipping the ones it says it doesn't need), for samples of several
+	// sizes including 0, and checks that it counted every item and kept the right number of them.  Returns true if
+	// it passed.
+	inline bool checkReservoirCounts(std::ostream& out)
+	{
+		constexpr std::uint64_t items { 10'000 };
+
+		bool passed { true };
+		for (std::size_t k : { std::size_t { 0 }, std::size_t { 1 }, std::size_t { 10 }, std::size_t { 20'000 } })
+		{
+			Random::ReservoirSampler<std::uint64_t> sampler { k };
+			for (std::uint64_t i { 0 }; i < items; ++i)
+			{
+				if (sampler.skipAhead() > 0)
+					sampler.skip(1);
+				else
+					sampler.add(i);
+			}
+
+			if (sampler.seen() != items || sampler.sample().size() != std::min<std::size_t>(k, items))
+				passed = false;
+		}
+
+		out << "reservoir check: seen() and sample() sizes for k = 0, 1, 10 and 20000" << (passed ? "  ok\n" : "  FAIL\n");
+		return passed;
+	}
+
+	// Prints one line per check, and returns how many failed
+	inline std::size_t printChecks(std::ostream& out, const std::vector<Check>& checks)
+	{
+		out << std::left << std::setw(16) << "engine" << std::setw(24) << "check" << std::right << std::setw(14) << "statistic"
+			<< std::setw(12) << "p-value" << '\n';
+
+		std::size_t failures { 0 };
+		for (const auto& c : checks)
+		{
+			out << std::left << std::setw(16) << c.engine << std::setw(24) << c.name << std::right
+				<< std::setw(14) << std::setprecision(6) << c.statistic << std::setw(12) << std::setprecision(4) << c.pValue
+				<< (c.passed() ? "  ok\n" : "  FAIL\n");
+			if (!c.passed())
+				++failures;
+		}
+
+		return failures;
+	}
+}
+
+#endif
@@ -0,0 +1,530 @@
+#include <algorithm> // for std::max, std::shuffle
+#include <array>
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::strtoul, std::strtoull
+#include <iostream>
+#include <numeric> // for std::iota
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread> // for std::jthread
+#include <utility> // for std::move
+#include <vector>
+
+#include "Benchmark.h"
+#include "Random.h"
+#include "RandomFill.h"
+#include "RandomQuality.h"
+
+// Measures the cost of generating random numbers with Random.h.
+//
+// Each benchmark draws numbers the way one of our programs does, once through a std::uniform_int_distribution (which
+// is what Random::get used to do, "dist") and once through Random::get ("get").  Both use the same generator (Random::mt), so the
+// difference is only in how a random 32-bit value is turned into a number in the range we asked for.
+//
+// The engine/ and threads/ benchmarks compare the generators themselves, in nanoseconds per value, and the quality
+// checks afterwards (see RandomQuality.h) make sure the faster ones don't skew the results of a simulation.
+
+// Draws a number in [min, max] the old way, constructing a distribution every time
+template <typename T>
+T getWithDistribution(T min, T max)
+{
+	return std::uniform_int_distribution<T>{ min, max }(Random::mt);
+}
+
+std::vector<Benchmark::Result> runBoundedBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	// MonsterGenerator::generate() picks a name and a roar with Random::get(0, 5), and hit points with Random::get(1, 100)
+	results.push_back(Benchmark::run("bounded/dist [0, 5]", []() {
+		Benchmark::doNotOptimize(getWithDistribution(0, 5));
+	}, options));
+	results.push_back(Benchmark::run("bounded/get [0, 5]", []() {
+		Benchmark::doNotOptimize(Random::get(0, 5));
+	}, options));
+
+	results.push_back(Benchmark::run("bounded/dist [1, 100]", []() {
+		Benchmark::doNotOptimize(getWithDistribution(1, 100));
+	}, options));
+	results.push_back(Benchmark::run("bounded/get [1, 100]", []() {
+		Benchmark::doNotOptimize(Random::get(1, 100));
+	}, options));
+
+	// WordList::getRandomWord() uses std::size_t, which takes two 32-bit values from std::mt19937
+	results.push_back(Benchmark::run("bounded/dist size_t [0, 9]", []() {
+		Benchmark::doNotOptimize(getWithDistribution<std::size_t>(0, 9));
+	}, options));
+	results.push_back(Benchmark::run("bounded/get size_t [0, 9]", []() {
+		Benchmark::doNotOptimize(Random::get<std::size_t>(0, 9));
+	}, options));
+
+	// A Fisher-Yates shuffle of a deck draws one number from each of [0, 51], [0, 50], ... [0, 1]
+	results.push_back(Benchmark::run("bounded/dist deck (51 draws)", []() {
+		for (int i { 51 }; i > 0; --i)
+			Benchmark::doNotOptimize(getWithDistribution(0, i));
+	}, options));
+	results.push_back(Benchmark::run("bounded/get deck (51 draws)", []() {
+		for (int i { 51 }; i > 0; --i)
+			Benchmark::doNotOptimize(Random::get(0, i));
+	}, options));
+
+	return results;
+}
+
+// Filling a buffer of a million values: one Random::get() call per value, against one Random::fill() call
+std::vector<Benchmark::Result> runFillBenchmarks(const Benchmark::Options& options)
+{
+	constexpr std::size_t count { 1 << 20 };
+	std::vector<Benchmark::Result> results {};
+
+	std::vector<int> dice(count);
+	results.push_back(Benchmark::run("fill/get loop 1M [1, 6]", [&dice]() {
+		for (auto& d : dice)
+			d = Random::get(1, 6);
+		Benchmark::doNotOptimize(dice);
+	}, options));
+	results.push_back(Benchmark::run("fill/fill 1M [1, 6]", [&dice]() {
+		Random::fill(dice, 1, 6);
+		Benchmark::doNotOptimize(dice);
+	}, options));
+
+	std::vector<double> samples(count);
+	results.push_back(Benchmark::run("fill/real dist loop 1M double", [&samples]() {
+		std::uniform_real_distribution die { 0.0, 1.0 };
+		for (auto& s : samples)
+			s = die(Random::mt);
+		Benchmark::doNotOptimize(samples);
+	}, options));
+	results.push_back(Benchmark::run("fill/fill 1M double", [&samples]() {
+		Random::fill(samples, 0.0, 1.0);
+		Benchmark::doNotOptimize(samples);
+	}, options));
+
+	// The raw generator, for each instruction set this CPU supports (256 64-bit values per refill)
+	Random::BulkGenerator generator { 42 };
+	constexpr std::string_view isaNames[] { "scalar", "sse2", "avx2" };
+	for (auto isa : { Random::BulkGenerator::Isa::scalar, Random::BulkGenerator::Isa::sse2, Random::BulkGenerator::Isa::avx2 })
+	{
+		if (isa > Random::BulkGenerator::isa())
+			break;
+
+		results.push_back(Benchmark::run("fill/refill 256 (" + std::string { isaNames[static_cast<int>(isa)] } + ")",
+			[&generator, isa]() {
+				generator.refill(isa);
+				Benchmark::doNotOptimize(generator.block());
+			}, options));
+	}
+
+	return results;
+}
+
+// Shuffling a 52 card deck (as Deck::shuffle does) and a million values: std::shuffle against Random::shuffle
+std::vector<Benchmark::Result> runShuffleBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	std::array<int, 52> deck {};
+	std::iota(deck.begin(), deck.end(), 0);
+	Random::Philox4x32 philox { 42 };
+
+	results.push_back(Benchmark::run("shuffle/std deck", [&deck]() {
+		std::shuffle(deck.begin(), deck.end(), Random::mt);
+		Benchmark::doNotOptimize(deck);
+	}, options));
+	results.push_back(Benchmark::run("shuffle/batched deck", [&deck]() {
+		Random::shuffle(deck.begin(), deck.end(), Random::mt);
+		Benchmark::doNotOptimize(deck);
+	}, options));
+	results.push_back(Benchmark::run("shuffle/batched array", [&deck]() {
+		Random::shuffle(deck);
+		Benchmark::doNotOptimize(deck);
+	}, options));
+
+	// The simulator shuffles with a Philox4x32 per hand
+	results.push_back(Benchmark::run("shuffle/std deck (philox)", [&deck, &philox]() {
+		std::shuffle(deck.begin(), deck.end(), philox);
+		Benchmark::doNotOptimize(deck);
+	}, options));
+	results.push_back(Benchmark::run("shuffle/batched array (philox)", [&deck, &philox]() {
+		Random::shuffle(deck, philox);
+		Benchmark::doNotOptimize(deck);
+	}, options));
+
+	std::vector<int> values(1 << 20);
+	std::iota(values.begin(), values.end(), 0);
+	results.push_back(Benchmark::run("shuffle/std 1M", [&values]() {
+		std::shuffle(values.begin(), values.end(), Random::mt);
+		Benchmark::doNotOptimize(values);
+	}, options));
+	results.push_back(Benchmark::run("shuffle/batched 1M", [&values]() {
+		Random::shuffle(values.begin(), values.end(), Random::mt);
+		Benchmark::doNotOptimize(values);
+	}, options));
+
+	return results;
+}
+
+// Choosing 10 different words out of a million: copying and shuffling the whole list against Random::sample (Floyd's
+// algorithm) and a ReservoirSampler reading the list as a stream
+std::vector<Benchmark::Result> runSampleBenchmarks(const Benchmark::Options& options)
+{
+	constexpr std::size_t sampleSize { 10 };
+	std::vector<Benchmark::Result> results {};
+
+	std::vector<int> words(1 << 20);
+	std::iota(words.begin(), words.end(), 0);
+
+	results.push_back(Benchmark::run("sample/copy and shuffle 10 of 1M", [&words]() {
+		std::vector<int> copy { words };
+		Random::shuffle(copy.begin(), copy.end(), Random::mt);
+		copy.resize(sampleSize);
+		Benchmark::doNotOptimize(copy);
+	}, options));
+	results.push_back(Benchmark::run("sample/floyd 10 of 1M", [&words]() {
+		Benchmark::doNotOptimize(Random::sample(words, sampleSize));
+	}, options));
+	results.push_back(Benchmark::run("sample/floyd 1000 of 1M", [&words]() {
+		Benchmark::doNotOptimize(Random::sample(words, 1000));
+	}, options));
+	results.push_back(Benchmark::run("sample/reservoir 10 of 1M", [&words]() {
+		Random::ReservoirSampler<int> sampler { sampleSize };
+		for (int word : words)
+		{
+			if (sampler.skipAhead() > 0)
+				sampler.skip(1);
+			else
+				sampler.add(word);
+		}
+		Benchmark::doNotOptimize(sampler.sample());
+	}, options));
+
+	return results;
+}
+
+// Weighted choices, e.g. MonsterGenerator's spawn rates: std::discrete_distribution (a binary search per draw)
+// against Random::AliasTable, for a handful of weights and for many
+std::vector<Benchmark::Result> runWeightedBenchmarks(const Benchmark::Options& options)
+{
+	constexpr std::size_t count { 1 << 20 };
+	std::vector<Benchmark::Result> results {};
+
+	for (std::size_t size : { std::size_t { 8 }, std::size_t { 10000 } })
+	{
+		std::vector<double> weights(size);
+		Random::fill(weights, 0.0, 1.0);
+		std::string suffix { " (" + std::to_string(size) + " weights)" };
+
+		std::discrete_distribution<std::size_t> distribution { weights.begin(), weights.end() };
+		Random::AliasTable table { weights };
+
+		results.push_back(Benchmark::run("weighted/discrete dist" + suffix, [&distribution]() {
+			Benchmark::doNotOptimize(distribution(Random::mt));
+		}, options));
+		results.push_back(Benchmark::run("weighted/alias" + suffix, [&table]() {
+			Benchmark::doNotOptimize(table());
+		}, options));
+
+		std::vector<int> indices(count);
+		results.push_back(Benchmark::run("weighted/alias fill 1M" + suffix, [&indices, &table]() {
+			Random::fill(indices, table);
+			Benchmark::doNotOptimize(indices);
+		}, options));
+	}
+
+	// Building the table, which is O(n)
+	std::vector<double> weights(count);
+	Random::fill(weights, 0.0, 1.0);
+	results.push_back(Benchmark::run("weighted/alias build 1M weights", [&weights]() {
+		Random::AliasTable table { weights };
+		Benchmark::doNotOptimize(table);
+	}, options));
+
+	return results;
+}
+
+// Continuous values: std::uniform_real_distribution and std::normal_distribution against uniform01() and normal(), one
+// value at a time and a million at a time
+std::vector<Benchmark::Result> runContinuousBenchmarks(const Benchmark::Options& options)
+{
+	constexpr std::size_t count { 1 << 20 };
+	std::vector<Benchmark::Result> results {};
+
+	results.push_back(Benchmark::run("continuous/real dist [0, 1)", []() {
+		std::uniform_real_distribution die { 0.0, 1.0 };
+		Benchmark::doNotOptimize(die(Random::mt));
+	}, options));
+	results.push_back(Benchmark::run("continuous/uniform01", []() {
+		Benchmark::doNotOptimize(Random::uniform01());
+	}, options));
+
+	// std::normal_distribution makes values in pairs and keeps the second one, so it is only fair to keep it around
+	std::normal_distribution<double> normalDistribution {};
+	results.push_back(Benchmark::run("continuous/normal dist", [&normalDistribution]() {
+		Benchmark::doNotOptimize(normalDistribution(Random::mt));
+	}, options));
+	results.push_back(Benchmark::run("continuous/normal", []() {
+		Benchmark::doNotOptimize(Random::normal());
+	}, options));
+
+	std::vector<double> samples(count);
+	results.push_back(Benchmark::run("continuous/normal dist loop 1M", [&samples, &normalDistribution]() {
+		for (auto& s : samples)
+			s = normalDistribution(Random::mt);
+		Benchmark::doNotOptimize(samples);
+	}, options));
+	results.push_back(Benchmark::run("continuous/fillUniform01 1M", [&samples]() {
+		Random::fillUniform01(samples);
+		Benchmark::doNotOptimize(samples);
+	}, options));
+	results.push_back(Benchmark::run("continuous/fillNormal 1M", [&samples]() {
+		Random::fillNormal(samples);
+		Benchmark::doNotOptimize(samples);
+	}, options));
+
+	// A Monte Carlo version of the chapter 4 ball drop: the tower's height is only known to within about half a meter
+	// and the stopwatch to within a tenth of a second, so how high is the ball after 3 seconds, on average?
+	auto calculateBallHeight { [](double towerHeight, double seconds) {
+		return std::max(0.0, towerHeight - (9.8 * seconds * seconds) / 2.0);
+	} };
+
+	results.push_back(Benchmark::run("continuous/ball drop std 1M", [&calculateBallHeight, &normalDistribution]() {
+		double total { 0.0 };
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			double height { 100.0 + 0.5 * normalDistribution(Random::mt) };
+			double seconds { 3.0 + 0.1 * normalDistribution(Random::mt) };
+			total += calculateBallHeight(height, seconds);
+		}
+		Benchmark::doNotOptimize(total / count);
+	}, options));
+
+	std::vector<double> heights(count);
+	std::vector<double> seconds(count);
+	results.push_back(Benchmark::run("continuous/ball drop fill 1M", [&]() {
+		Random::fillNormal(heights, 100.0, 0.5);
+		Random::fillNormal(seconds, 3.0, 0.1);
+
+		double total { 0.0 };
+		for (std::size_t i { 0 }; i < count; ++i)
+			total += calculateBallHeight(heights[i], seconds[i]);
+		Benchmark::doNotOptimize(total / count);
+	}, options));
+
+	return results;
+}
+
+// Turns a result for a batch of count values into one for a single value, so everything can be compared in ns/value
+Benchmark::Result perValue(Benchmark::Result result, std::size_t count)
+{
+	for (double& s : result.samples)
+		s /= static_cast<double>(count);
+	Benchmark::finish(result);
+	return result;
+}
+
+// Calls f(name, makeEngine) for every engine in Random.h (and the standard ones they replace), where makeEngine(stream)
+// returns a new engine seeded from the master seed and that stream, so each thread can have its own
+template <typename F>
+void forEachEngine(F&& f)
+{
+	f("mt19937", [](std::uint64_t stream) { return Random::generate(stream); });
+	f("mt19937_64", [](std::uint64_t stream) { return std::mt19937_64 { Random::SplitMix64 { Random::masterSeed(), stream }() }; });
+	f("splitmix64", [](std::uint64_t stream) { return Random::SplitMix64 { Random::masterSeed(), stream }; });
+	f("pcg32", [](std::uint64_t stream) { return Random::Pcg32 { Random::masterSeed(), stream }; });
+	f("xoshiro256**", [](std::uint64_t stream) { return Random::Xoshiro256StarStar { Random::masterSeed(), stream }; });
+	f("philox4x32", [](std::uint64_t stream) { return Random::Philox4x32 { Random::masterSeed(), stream }; });
+	f("bulk", [](std::uint64_t stream) { return Random::BulkGenerator { Random::SplitMix64 { Random::masterSeed(), stream }() }; });
+}
+
+// One value at a time from engine: its raw output, and each distribution in Random.h that takes an engine
+template <typename Engine>
+void runEngineBenchmarks(std::vector<Benchmark::Result>& results, std::string_view name, Engine& engine,
+	const Benchmark::Options& options)
+{
+	std::string prefix { "engine/" + std::string { name } };
+
+	results.push_back(Benchmark::run(prefix + " raw", [&engine]() {
+		Benchmark::doNotOptimize(engine());
+	}, options));
+	results.push_back(Benchmark::run(prefix + " get [1, 6]", [&engine]() {
+		Benchmark::doNotOptimize(Random::get(engine, 1, 6));
+	}, options));
+	results.push_back(Benchmark::run(prefix + " uniform01", [&engine]() {
+		Benchmark::doNotOptimize(Random::uniform01(engine));
+	}, options));
+	results.push_back(Benchmark::run(prefix + " normal", [&engine]() {
+		Benchmark::doNotOptimize(Random::normal(engine));
+	}, options));
+
+	// Per card, so it can be compared with the others
+	std::array<int, 52> deck {};
+	std::iota(deck.begin(), deck.end(), 0);
+	results.push_back(perValue(Benchmark::run(prefix + " shuffle", [&deck, &engine]() {
+		Random::shuffle(deck, engine);
+		Benchmark::doNotOptimize(deck);
+	}, options), deck.size()));
+}
+
+std::vector<Benchmark::Result> runAllEngineBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	forEachEngine([&results, &options](std::string_view name, auto makeEngine) {
+		auto engine { makeEngine(0) };
+		runEngineBenchmarks(results, name, engine, options);
+	});
+
+	// Whichever engine Random::mt was built with (see RANDOM_ENGINE in Random.h), behind its lazy, fork-safe handle
+	runEngineBenchmarks(results, "Random::mt", Random::mt, options);
+
+	return results;
+}
+
+// Every thread draws valuesPerThread values with draw(engine), from its own engine (made by makeEngine, with the
+// thread's number as the stream).  The result is wall clock time divided by all the values drawn, so if the threads
+// scale perfectly it is the single-threaded time divided by the number of threads.
+template <typename MakeEngine, typename Draw>
+Benchmark::Result runThreaded(std::string_view name, MakeEngine makeEngine, Draw draw, unsigned int threads,
+	const Benchmark::Options& options)
+{
+	constexpr std::size_t valuesPerThread { 1 << 20 };
+
+	Benchmark::Result result { Benchmark::run(name, [&makeEngine, &draw, threads]() {
+		std::vector<std::jthread> workers {};
+		for (unsigned int i { 0 }; i < threads; ++i)
+		{
+			workers.emplace_back([&makeEngine, &draw, i]() {
+				auto engine { makeEngine(i) };
+				for (std::size_t n { 0 }; n < valuesPerThread; ++n)
+					Benchmark::doNotOptimize(draw(engine));
+			});
+		}
+	}, options) };
+
+	return perValue(std::move(result), valuesPerThread * threads);
+}
+
+std::vector<Benchmark::Result> runThreadedBenchmarks(const Benchmark::Options& options, unsigned int threads)
+{
+	std::vector<Benchmark::Result> results {};
+
+	forEachEngine([&results, &options, threads](std::string_view name, auto makeEngine) {
+		results.push_back(runThreaded("threads/" + std::string { name } + " raw", makeEngine,
+			[](auto& engine) { return engine(); }, threads, options));
+	});
+
+#ifdef RANDOM_THREAD_LOCAL
+	// The draws our programs actually make, each thread from its own Random::mt
+	auto threadEngine { [](std::uint64_t stream) {
+		Random::seedThread(stream);
+		return Random::mt;
+	} };
+	results.push_back(runThreaded("threads/Random::mt get [1, 6]", threadEngine,
+		[](auto& engine) { return Random::get(engine, 1, 6); }, threads, options));
+	results.push_back(runThreaded("threads/Random::mt normal", threadEngine,
+		[](auto& engine) { return Random::normal(engine); }, threads, options));
+
+	// Random::fill keeps a BulkGenerator per thread
+	std::vector<std::vector<int>> dice(threads, std::vector<int>(1 << 20));
+	results.push_back(perValue(Benchmark::run("threads/fill 1M [1, 6]", [&dice, threads]() {
+		std::vector<std::jthread> workers {};
+		for (unsigned int i { 0 }; i < threads; ++i)
+		{
+			workers.emplace_back([&dice, i]() {
+				Random::fill(dice[i], 1, 6);
+				Benchmark::doNotOptimize(dice[i]);
+			});
+		}
+	}, options), dice[0].size() * threads));
+#endif
+
+	return results;
+}
+
+// Puts every engine (and Random::mt, std::minstd_rand and Random::fill) through the checks in RandomQuality.h, printing
+// the die roll histograms and a table of results to out.  Returns the number of checks that failed.
+std::size_t runQualityChecks(std::ostream& out)
+{
+	constexpr std::size_t count { 1 << 22 };
+	std::vector<Quality::Check> checks {};
+
+	forEachEngine([&checks, &out](std::string_view name, auto makeEngine) {
+		auto engine { makeEngine(0) };
+		Quality::checkEngine(checks, name, engine, count, out);
+	});
+	Quality::checkEngine(checks, "Random::mt", Random::mt, count, out);
+
+	// Only 31 bits per value (and never 0), so Random.h has to stitch values together before it can use them
+	std::minstd_rand narrow { static_cast<std::minstd_rand::result_type>(Random::SplitMix64 { Random::masterSeed(), 0 }()) };
+	Quality::checkEngine(checks, "minstd_rand", narrow, count, out);
+	Quality::checkFill(checks, count);
+
+	out << "\nQuality checks (seed " << Random::masterSeed() << ", " << count << " values each, failing if p < "
+		<< Quality::alpha << " or p > 1 - " << Quality::alpha << ")\n";
+	std::size_t failures { Quality::printChecks(out, checks) };
+	out << failures << (failures == 1 ? " check" : " checks") << " failed\n";
+
+	return failures;
+}
+
+// Usage: Random_Benchmarks [--seed <n>] [--threads <n>] [--json] [--check]
+int main(int argc, char* argv[])
+{
+	bool json { false };
+	bool checkOnly { false };
+	unsigned int threads { std::max(1u, std::thread::hardware_concurrency()) };
+	for (int i { 1 }; i < argc; ++i)
+	{
+		std::string_view arg { argv[i] };
+		if (arg == "--json")
+			json = true;
+		else if (arg == "--check")
+			checkOnly = true;
+		else if (arg == "--seed" && i + 1 < argc)
+			Random::reseed(std::strtoull(argv[++i], nullptr, 0));
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+	}
+
+	// This has to come before anything uses Random::mt (see Quality::checkForkedChildren)
+	bool forkPassed { Quality::checkForkedChildren(json ? std::cerr : std::cout) };
+	bool reservoirPassed { Quality::checkReservoirCounts(json ? std::cerr : std::cout) };
+	bool bulkPassed { Quality::checkBulkIsas(json ? std::cerr : std::cout) };
+	bool passed { forkPassed && reservoirPassed && bulkPassed };
+
+	// --check skips the benchmarks, and only runs the (much quicker) quality checks
+	if (checkOnly)
+		return (runQualityChecks(std::cout) == 0 && passed) ? 0 : 1;
+
+	Benchmark::Options options {};
+
+	std::vector<Benchmark::Result> results { runBoundedBenchmarks(options) };
+	for (auto& r : runFillBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runShuffleBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runSampleBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runWeightedBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runContinuousBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runAllEngineBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runThreadedBenchmarks(options, threads))
+		results.push_back(r);
+
+	if (json)
+		Benchmark::printJson(std::cout, results);
+	else
+	{
+		std::cout << "threads/ benchmarks use " << threads << (threads == 1 ? " thread\n" : " threads\n");
+		Benchmark::printText(std::cout, results);
+	}
+
+	// With --json, stdout is kept for the JSON, so the checks are printed to stderr
+	std::size_t failures { runQualityChecks(json ? std::cerr : std::cout) };
+	return (failures == 0 && passed) ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <iterator> // for std::size
 
 #include "Random.h"
 
@@ -83,9 +84,15 @@ namespace MonsterGenerator {
 		}
 	}
 
+	// How often each type of monster spawns, relative to the others (in the same order as Monster::Type)
+	constexpr int spawnRates[] { 1, 20, 8, 15, 12, 6, 3, 15 };
+	static_assert(std::size(spawnRates) == Monster::maxMonsterTypes);
+
+	const Random::AliasTable spawnTable { spawnRates };
+
 	Monster generate() {
 		return Monster {
-			static_cast<Monster::Type>(Random::get(0, Monster::maxMonsterTypes - 1)),
+			static_cast<Monster::Type>(spawnTable()),
 			getName(Random::get(0, 5)),
 			getRoar(Random::get(0, 5)),
 			Random::get(1, 100)
@@ -231,13 +231,22 @@ Add in display of incorrect letters guessed
 Add in win/loss condition and win/loss text.
  */
 
+#include <algorithm> // for std::ranges::all_of
 #include <cassert>
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::strtoull
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <string>
 #include <string_view>
 #include <type_traits> // for std::is_integral and std::is_enum
 #include <vector>
+#include "LatencyHistogram.h"
+#include "Metrics.h" // set LEARNCPP_METRICS=<name> and run MetricsReader <name> to watch guesses live
+#include "Profiler.h"
 #include "Random.h"
+#include "SamplingProfiler.h" // set LEARNCPP_PROFILE=<file> to write a folded-stack CPU profile
 
 namespace Items
 {
@@ -344,6 +353,9 @@ void printArray(const std::vector<T>& v)
 namespace Settings
 {
     constexpr int wrongGuessesAllowed { 6 };
+
+    // How many words to keep from a dictionary file (see WordList::loadPuzzleSet)
+    constexpr std::size_t puzzleSetSize { 100 };
 }
 
 namespace WordList
@@ -351,23 +363,92 @@ namespace WordList
     // Define your list of words here
     std::vector<std::string_view> words { "mystery", "broccoli" , "account", "almost", "spaghetti", "opinion", "beautiful", "distance", "luggage" };
 
+    // Roughly how common each word is in everyday English, so common words come up more often than rare ones
+    std::vector<int> frequencies { 30, 3, 120, 400, 4, 90, 150, 60, 6 };
+
+    const Random::AliasTable& wordTable()
+    {
+        assert(frequencies.size() == words.size());
+        static const Random::AliasTable s_table { frequencies };
+        return s_table;
+    }
+
     std::string_view getRandomWord()
     {
-        return words[Random::get<std::size_t>(0, words.size()-1)];
+        return words[wordTable()()];
+    }
+
+    // The same, using a random number generator of our own
+    template <typename Engine>
+    std::string_view getRandomWord(Engine& engine)
+    {
+        return words[wordTable()(engine)];
+    }
+
+    // The words kept from a dictionary file, which words points into
+    std::vector<std::string> puzzleSet {};
+
+    // Replaces words with a random set of Settings::puzzleSetSize words from a file with one word per line.  The file
+    // can be far bigger than we'd want to keep in memory: every line is read into the same buffer, and only the words
+    // the reservoir sampler keeps are copied out of it.  Only the words C++man can use are offered to the sampler, so
+    // each of them is equally likely to be picked, and we get a full set whenever the file has enough of them.
+    // Must be called before the first call to getRandomWord().
+    bool loadPuzzleSet(const char* path)
+    {
+        std::ifstream file { path };
+        if (!file)
+            return false;
+
+        Random::ReservoirSampler<std::string> sampler { Settings::puzzleSetSize };
+        std::string line {};
+        while (std::getline(file, line))
+        {
+            // Dictionaries saved on Windows end each line with "\r\n"
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            // C++man can only be won with words made of lowercase letters
+            if (line.empty() || !std::ranges::all_of(line, [](char c) { return c >= 'a' && c <= 'z'; }))
+                continue;
+
+            if (sampler.skipAhead() > 0)
+                sampler.skip(1);
+            else
+                sampler.add(line);
+        }
+
+        puzzleSet = std::move(sampler).sample();
+
+        if (puzzleSet.empty())
+            return false;
+
+        words.assign(puzzleSet.begin(), puzzleSet.end());
+        frequencies.assign(words.size(), 1);
+        return true;
     }
 }
 
 class Session
 {
 private:
+    // Each session has its own small random number generator (16 bytes, where a std::mt19937 would be 5000), so a
+    // server can keep a million sessions around, and session n gets the same word for the same master seed however
+    // many other sessions there are
+    Random::Pcg32 m_rng;
+
     // Game session data
-    std::string_view m_word { WordList::getRandomWord() };
+    std::string_view m_word { WordList::getRandomWord(m_rng) };
     int m_wrongGuessesLeft { Settings::wrongGuessesAllowed };
     std::vector<bool> m_letterGuessed { std::vector<bool>(26) };
 
     std::size_t toIndex(char c) const { return static_cast<std::size_t>((c % 32)-1); }
 
 public:
+    explicit Session(std::uint64_t id = 0)
+        : m_rng { Random::masterSeed(), id }
+    {
+    }
+
     std::string_view getWord() const { return m_word; }
 
     int wrongGuessesLeft() const { return m_wrongGuessesLeft; }
@@ -401,6 +482,8 @@ public:
 
 void draw(const Session& s)
 {
+    PROFILE_FUNCTION();
+
     std::cout << '\n';
 
     std::cout << "The word: ";
@@ -426,6 +509,8 @@ void draw(const Session& s)
 
 char getGuess(const Session& s)
 {
+    PROFILE_FUNCTION();
+
     while (true)
     {
         std::cout << "Enter your next letter: ";
@@ -467,6 +552,11 @@ char getGuess(const Session& s)
 
 void handleGuess(Session &s, char c)
 {
+    PROFILE_FUNCTION();
+    static Metrics::Counter guesses { Metrics::counter("cppman.guesses") };
+    static Metrics::Counter wrongGuesses { Metrics::counter("cppman.wrongGuesses") };
+    guesses.add();
+
     s.setLetterGuessed(c);
 
     if (s.isLetterInWord(c))
@@ -477,10 +567,30 @@ void handleGuess(Session &s, char c)
 
     std::cout << "No, '" << c << "' is not in the word!\n";
     s.removeGuess();
+    wrongGuesses.add();
 }
 
-int main()
+// Pass --latency to print the per-guess latency distribution after the game,
+// --seed <n> to play the same word again (see Random.h),
+// and --words <file> to pick the word from a dictionary file (one word per line, e.g. /usr/share/dict/words)
+int main(int argc, char* argv[])
 {
+    bool printLatency { false };
+    for (int i { 1 }; i < argc; ++i)
+    {
+        std::string_view arg { argv[i] };
+        if (arg == "--latency")
+            printLatency = true;
+        else if (arg == "--seed" && i + 1 < argc)
+            Random::reseed(std::strtoull(argv[++i], nullptr, 0));
+        else if (arg == "--words" && i + 1 < argc)
+        {
+            const char* path { argv[++i] };
+            if (!WordList::loadPuzzleSet(path))
+                std::cerr << "Couldn't read any words from " << path << ", using the built-in list\n";
+        }
+    }
+
     std::vector inventory { 1, 5, 10 };
     assert(std::size(inventory) == Items::max_items); // make sure our inventory has the correct number of initializers
 
@@ -534,22 +644,40 @@ int main()
     std::cout << "Welcome to C++man (a variant of Hangman)\n";
     std::cout << "To win: guess the word.  To lose: run out of pluses.\n";
 
-    Session s{};
-
-    while (s.wrongGuessesLeft() && !s.won())
     {
+        PROFILE_SCOPE("C++man session");
+
+        Session s{};
+        LatencyHistogram guessLatency {};
+
+        while (s.wrongGuessesLeft() && !s.won())
+        {
+            draw(s);
+            char c { getGuess(s) };
+
+            // Time how long we take to handle the guess (but not how long the player took to make it)
+            Timer t {};
+            handleGuess(s, c);
+            guessLatency.recordElapsed(t);
+        }
+
+        // Draw the final state of the game
         draw(s);
-        char c { getGuess(s) };
-        handleGuess(s, c);
-    }
 
-    // Draw the final state of the game
-    draw(s);
+        if (!s.wrongGuessesLeft())
+            std::cout << "You lost!  The word was: " << s.getWord() << '\n';
+        else
+            std::cout << "You won!\n";
 
-    if (!s.wrongGuessesLeft())
-        std::cout << "You lost!  The word was: " << s.getWord() << '\n';
-    else
-        std::cout << "You won!\n";
+        if (printLatency)
+        {
+            std::cout << "\nPer-guess latency: ";
+            guessLatency.printPercentiles(std::cout);
+        }
+    }
+
+    // Only does anything when built with ENABLE_PROFILING
+    PROFILE_WRITE_TRACE("Chapter_16_Summary.trace.json");
 
     return 0;
 }
\ No newline at end of file
@@ -1,8 +1,16 @@
-#include <algorithm> // for std::shuffle
 #include <array>
 #include <cassert>
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::strtol, std::strtoull
 #include <iostream>
+#include <string_view>
+#include <thread> // for std::jthread
+#include <vector>
+#include "LatencyHistogram.h"
+#include "Metrics.h" // set LEARNCPP_METRICS=<name> and run MetricsReader <name> to watch a simulation live
+#include "Profiler.h"
 #include "Random.h"
+#include "SamplingProfiler.h" // set LEARNCPP_PROFILE=<file> to write a folded-stack CPU profile
 
 namespace Settings
 {
@@ -83,7 +91,16 @@ public:
 
     void shuffle()
     {
-        std::shuffle(m_cards.begin(), m_cards.end(), Random::mt);
+        shuffle(Random::mt);
+    }
+
+    // Shuffles using a random number generator of our own choosing (e.g. one stream of a Random::Philox4x32).
+    // Random::shuffle gets several card positions out of each random value, where std::shuffle gets at most two.
+    template <typename Engine>
+    void shuffle(Engine& engine)
+    {
+        PROFILE_FUNCTION();
+        Random::shuffle(m_cards, engine);
         m_nextCardIndex = 0;
     }
 
@@ -126,8 +143,12 @@ public:
     int score() { return m_score; }
 };
 
-bool playerWantsHit()
+// In a simulated (non-interactive) game, the player just follows the same rule as the dealer
+bool playerWantsHit(Player& player, bool interactive)
 {
+    if (!interactive)
+        return player.score() < Settings::dealerStopsAt;
+
     while (true)
     {
         std::cout << "(h) to hit, or (s) to stand: ";
@@ -146,19 +167,22 @@ bool playerWantsHit()
 }
 
 // Returns true if the player went bust. False otherwise.
-bool playerTurn(Deck& deck, Player& player)
+bool playerTurn(Deck& deck, Player& player, bool interactive)
 {
-    while (player.score() < Settings::bust && playerWantsHit())
+    PROFILE_FUNCTION();
+    while (player.score() < Settings::bust && playerWantsHit(player, interactive))
     {
         Card card { deck.dealCard() };
         player.addToScore(card);
 
-        std::cout << "You were dealt " << card  << ". You now have: " << player.score() << '\n';
+        if (interactive)
+            std::cout << "You were dealt " << card  << ". You now have: " << player.score() << '\n';
     }
 
     if (player.score() > Settings::bust)
     {
-        std::cout << "You went bust!\n";
+        if (interactive)
+            std::cout << "You went bust!\n";
         return true;
     }
 
@@ -167,19 +191,22 @@ bool playerTurn(Deck& deck, Player& player)
 
 
 // Returns true if the dealer went bust. False otherwise.
-bool dealerTurn(Deck& deck, Player& dealer)
+bool dealerTurn(Deck& deck, Player& dealer, bool interactive)
 {
+    PROFILE_FUNCTION();
     while (dealer.score() < Settings::dealerStopsAt)
     {
         Card card { deck.dealCard() };
         dealer.addToScore(card);
 
-        std::cout << "The dealer flips a " << card << ".  They now have: " << dealer.score() << '\n';
+        if (interactive)
+            std::cout << "The dealer flips a " << card << ".  They now have: " << dealer.score() << '\n';
     }
 
     if (dealer.score() > Settings::bust)
     {
-        std::cout << "The dealer went bust!\n";
+        if (interactive)
+            std::cout << "The dealer went bust!\n";
         return true;
     }
 
@@ -193,27 +220,33 @@ enum class GameResult
     tie
 };
 
-GameResult playBlackjack()
+// The deck is shuffled using engine.
+// If interactive is false, the player's decisions are made automatically and nothing is printed
+template <typename Engine>
+GameResult playBlackjack(Engine& engine, bool interactive)
 {
+    PROFILE_FUNCTION();
     Deck deck{};
-    deck.shuffle();
+    deck.shuffle(engine);
 
     Player dealer{};
     Card card1 { deck.dealCard() };
     dealer.addToScore(card1);
-    std::cout << "The dealer is showing " << card1 << " (" << dealer.score() << ")\n";
+    if (interactive)
+        std::cout << "The dealer is showing " << card1 << " (" << dealer.score() << ")\n";
 
     Player player{};
     Card card2 { deck.dealCard() };
     Card card3 { deck.dealCard() };
     player.addToScore(card2);
     player.addToScore(card3);
-    std::cout << "You are showing " << card2 << ' ' << card3 << " (" << player.score() << ")\n";
+    if (interactive)
+        std::cout << "You are showing " << card2 << ' ' << card3 << " (" << player.score() << ")\n";
 
-    if (playerTurn(deck, player)) // if player busted
+    if (playerTurn(deck, player, interactive)) // if player busted
         return GameResult::dealerWon;
 
-    if (dealerTurn(deck, dealer)) // if dealer busted
+    if (dealerTurn(deck, dealer, interactive)) // if dealer busted
         return GameResult::playerWon;
 
     if (player.score() == dealer.score())
@@ -222,20 +255,129 @@ GameResult playBlackjack()
     return (player.score() > dealer.score() ? GameResult::playerWon : GameResult::dealerWon);
 }
 
-int main()
+// Results of playing a batch of hands
+struct SimulationResult
+{
+    LatencyHistogram latency {};
+    long wins { 0 };
+    long losses { 0 };
+    long ties { 0 };
+};
+
+// Plays hands number [first, first + hands) non-interactively
+SimulationResult playHands(long first, long hands)
+{
+    // Exported live through shared memory, so a long simulation can be watched while it runs
+    static Metrics::Counter handsPlayed { Metrics::counter("blackjack.hands") };
+    static Metrics::Counter playerWins { Metrics::counter("blackjack.playerWins") };
+    static Metrics::Counter dealerWins { Metrics::counter("blackjack.dealerWins") };
+    static Metrics::Histogram handTime { Metrics::histogram("blackjack.handNs") };
+
+    SimulationResult r {};
+    for (long i { first }; i < first + hands; ++i)
+    {
+        // Every hand gets its own random number stream, so hand i is dealt the same cards (for the same master seed)
+        // whichever thread plays it, and the totals don't depend on how many threads there are
+        Random::Philox4x32 rng { Random::masterSeed(), static_cast<std::uint64_t>(i) };
+
+        Timer hand {};
+        GameResult result { playBlackjack(rng, false) };
+        double handSeconds { hand.elapsed() };
+        r.latency.recordSeconds(handSeconds);
+        handTime.recordSeconds(handSeconds);
+        handsPlayed.add();
+
+        switch (result)
+        {
+        case GameResult::playerWon: ++r.wins;   playerWins.add(); break;
+        case GameResult::dealerWon: ++r.losses; dealerWins.add(); break;
+        case GameResult::tie:       ++r.ties;   break;
+        }
+    }
+
+    return r;
+}
+
+// Plays hands non-interactively, split across threads, and reports the results and the per-hand latency distribution
+void simulate(long hands, unsigned int threads)
+{
+    std::vector<SimulationResult> results(threads);
+
+    Timer t {};
+    {
+        std::vector<std::jthread> workers {};
+        long first { 0 };
+        for (unsigned int i { 0 }; i < threads; ++i)
+        {
+            // Spread the remainder over the first few workers
+            long share { hands / threads + (i < hands % threads ? 1 : 0) };
+            workers.emplace_back([&results, first, share, i] { results[i] = playHands(first, share); });
+            first += share;
+        }
+    } // the jthreads join here
+    double seconds { t.elapsed() };
+
+    SimulationResult total {};
+    for (const auto& r : results)
+    {
+        total.latency.merge(r.latency);
+        total.wins += r.wins;
+        total.losses += r.losses;
+        total.ties += r.ties;
+    }
+
+    std::cout << "Played " << hands << " hands on " << threads << (threads == 1 ? " thread" : " threads")
+              << " in " << seconds << " seconds (" << static_cast<double>(hands) / seconds << " hands/sec)\n";
+    std::cout << "Seed " << Random::masterSeed() << " (pass --seed " << Random::masterSeed() << " to replay)\n";
+    std::cout << "Player won " << total.wins << ", lost " << total.losses << ", tied " << total.ties << '\n';
+    std::cout << "Per-hand latency: ";
+    total.latency.printPercentiles(std::cout);
+}
+
+// Usage: Blackjack                    play one interactive hand
+//        Blackjack --simulate <hands> [threads]
+//                                     play <hands> hands automatically (on [threads] threads, default 1) and report
+//                                     per-hand latency
+// Either can be preceded by --seed <n> to replay a run (the seed is printed by --simulate, or see Random.h)
+int main(int argc, char* argv[])
 {
-    switch (playBlackjack())
+    int arg { 1 };
+    if (argc >= arg + 2 && std::string_view { argv[arg] } == "--seed")
+    {
+        Random::reseed(std::strtoull(argv[arg + 1], nullptr, 0));
+        arg += 2;
+    }
+
+    if (argc >= arg + 2 && std::string_view { argv[arg] } == "--simulate")
+    {
+        long hands { std::strtol(argv[arg + 1], nullptr, 10) };
+        long threads { (argc >= arg + 3) ? std::strtol(argv[arg + 2], nullptr, 10) : 1 };
+        if (hands <= 0 || threads <= 0 || threads > 1024)
+        {
+            std::cout << "Usage: " << argv[0] << " [--seed <n>] --simulate <hands> [threads]\n";
+            return 1;
+        }
+
+        simulate(hands, static_cast<unsigned int>(threads));
+        PROFILE_WRITE_TRACE("Blackjack.trace.json");
+        return 0;
+    }
+
+    switch (playBlackjack(Random::mt, true))
     {
     case GameResult::playerWon:
         std::cout << "You win!\n";
-        return 0;
+        break;
     case GameResult::dealerWon:
         std::cout << "You lose!\n";
-        return 0;
+        break;
     case GameResult::tie:
         std::cout << "It's a tie.\n";
-        return 0;
+        break;
     }
 
+    // Only does anything when built with ENABLE_PROFILING
+    PROFILE_WRITE_TRACE("Blackjack.trace.json");
+
     return 0;
 }
\ No newline at end of file
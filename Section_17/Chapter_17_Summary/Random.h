@@ -1,39 +1,704 @@
 #ifndef RANDOM_MT_H
 #define RANDOM_MT_H
 
+#include <algorithm> // for std::shuffle, std::iter_swap, std::find, std::min
+#include <array>
+#include <atomic>
+#include <bit> // for std::bit_width
+#include <cassert>
 #include <chrono>
+#include <cmath> // for std::exp, std::log, std::log1p, std::sqrt, std::floor
+#include <concepts> // for std::integral, std::uniform_random_bit_generator
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t, std::uint64_t, std::int64_t
+#include <cstdlib> // for std::getenv, std::strtoull
+#include <initializer_list>
+#include <iostream>
+#include <iterator> // for std::random_access_iterator, std::iterator_traits
+#include <limits>
 #include <random>
+#include <ranges> // for std::ranges::input_range
+#include <span>
+#include <string_view>
+#include <type_traits> // for std::make_unsigned_t, std::is_arithmetic_v
+#include <unordered_set>
+#include <utility> // for std::index_sequence, std::forward, std::move
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <pthread.h> // for pthread_atfork
+	#include <unistd.h> // for getpid
+#endif
 
 // This header-only Random namespace implements a self-seeding Mersenne Twister.
-// Requires C++17 or newer.
+// Requires C++20 or newer.
 // It can be #included into as many code files as needed (The inline keyword avoids ODR violations)
 // Freely redistributable, courtesy of learncpp.com (https://www.learncpp.com/cpp-tutorial/global-random-numbers-random-h/)
 namespace Random
 {
-	// Returns a seeded Mersenne Twister
+	// Seeding, and replaying a run.
+	//
+	// Every generator in this file is seeded from one 64-bit master seed.  Normally it is chosen randomly (from the
+	// clock and std::random_device), so each run is different, and printed to std::cerr the first time it is used, so
+	// that any run can be replayed.  To reproduce a run exactly (e.g. to look at a slow or unusual game again under the
+	// profiler), set the LEARNCPP_SEED environment variable:
+	//   LEARNCPP_SEED=1234 ./Blackjack        use seed 1234 (decimal, or hex with 0x), without printing it
+	//   LEARNCPP_SEED=quiet ./Blackjack       choose a random seed, as usual, but don't print it
+	// Programs can also call Random::reseed() themselves, e.g. from a --seed command line option (which doesn't print
+	// the seed either, since the caller already knows it).
+	namespace detail
+	{
+		inline bool logSeed{ true }; // false when replaying a seed, or with LEARNCPP_SEED=quiet
+
+		inline std::uint64_t initialSeed()
+		{
+			const char* env{ std::getenv("LEARNCPP_SEED") };
+			if (env && *env)
+			{
+				char* end{};
+				std::uint64_t fixed{ std::strtoull(env, &end, 0) };
+				if (*end == '\0')
+				{
+					logSeed = false;
+					return fixed;
+				}
+
+				if (std::string_view{ env } == "quiet")
+					logSeed = false;
+			}
+
+			std::random_device rd{};
+			std::uint64_t seed{ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) };
+
+			seed ^= (static_cast<std::uint64_t>(rd()) << 32) | rd();
+			return seed;
+		}
+
+		inline void printSeed(std::uint64_t seed)
+		{
+			if (logSeed)
+				std::cerr << "Random: seed " << seed << " (set LEARNCPP_SEED=" << seed << " to replay this run)\n";
+		}
+
+		// Makes sure a fork() is noticed from now on (defined below, with Random::mt)
+		inline void watchForks();
+
+		inline std::uint64_t& seedStorage()
+		{
+			static std::uint64_t s_seed{ [] {
+				// Everything seeded from now on depends on the master seed, so a child process must get streams of its own
+				watchForks();
+				std::uint64_t seed{ initialSeed() };
+				printSeed(seed);
+				return seed;
+			}() };
+
+			return s_seed;
+		}
+	}
+
+	// The seed for this run
+	inline std::uint64_t masterSeed()
+	{
+		return detail::seedStorage();
+	}
+
+	// Small random number generators.
+	//
+	// std::mt19937 keeps 624 32-bit words of state (which libstdc++ stores in 64-bit words, so 5 KB), and seeding it
+	// properly means filling all of it.  That's fine for one global generator, but not for a generator inside every
+	// Deck or Session when there are a million of them.  These generators need 8 to 32 bytes, seed in a few
+	// instructions, are faster than std::mt19937, and pass the usual statistical tests (BigCrush, PractRand):
+	//   SplitMix64           8 bytes, 64-bit values.  Also used to seed the others.
+	//   Pcg32               16 bytes, 32-bit values.  Every stream is a different sequence.  (O'Neill, 2014)
+	//   Xoshiro256StarStar  32 bytes, 64-bit values, a period of 2^256 - 1.  (Blackman and Vigna, 2018)
+	// Like Philox4x32 (after these), each one is constructed from a seed (by default the master seed) and a stream
+	// number.
+	//
+	// Sample call: Random::Pcg32 rng{ Random::masterSeed(), sessionId };
+	// Sample call: Random::get(rng, 1, 6);
+	class SplitMix64
+	{
+	public:
+		using result_type = std::uint64_t;
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	private:
+		std::uint64_t m_state{};
+
+	public:
+		// Different streams start at unrelated points of the same 2^64 value sequence
+		explicit SplitMix64(std::uint64_t seed = masterSeed(), std::uint64_t stream = 0)
+			: m_state{ seed ^ mix(stream * 0x9E3779B97F4A7C15) }
+		{
+		}
+
+		// The output function on its own: scrambles x so that nearby inputs give unrelated outputs
+		static constexpr std::uint64_t mix(std::uint64_t x)
+		{
+			x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+			x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+			return x ^ (x >> 31);
+		}
+
+		result_type operator()()
+		{
+			return mix(m_state += 0x9E3779B97F4A7C15);
+		}
+
+		void discard(unsigned long long n)
+		{
+			for (; n > 0; --n)
+				(*this)();
+		}
+	};
+
+	class Pcg32
+	{
+	public:
+		using result_type = std::uint32_t;
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	private:
+		static constexpr std::uint64_t multiplier{ 6364136223846793005 };
+
+		std::uint64_t m_state{};
+		std::uint64_t m_increment{}; // always odd; chosen by the stream number
+
+		void step() { m_state = m_state * multiplier + m_increment; }
+
+	public:
+		explicit Pcg32(std::uint64_t seed = masterSeed(), std::uint64_t stream = 0)
+			: m_increment{ (stream << 1) | 1 }
+		{
+			step();
+			m_state += seed;
+			step();
+		}
+
+		// PCG-XSH-RR: the top bits of the state, shifted and xor-ed, then rotated by an amount taken from the top 5 bits
+		result_type operator()()
+		{
+			std::uint64_t old{ m_state };
+			step();
+			auto xorShifted{ static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27) };
+			auto rotation{ static_cast<int>(old >> 59) };
+			return std::rotr(xorShifted, rotation);
+		}
+
+		void discard(unsigned long long n)
+		{
+			for (; n > 0; --n)
+				(*this)();
+		}
+	};
+
+	class Xoshiro256StarStar
+	{
+	public:
+		using result_type = std::uint64_t;
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	private:
+		std::uint64_t m_state[4]{};
+
+	public:
+		// Seeded from SplitMix64, as xoshiro's authors recommend
+		explicit Xoshiro256StarStar(std::uint64_t seed = masterSeed(), std::uint64_t stream = 0)
+		{
+			SplitMix64 seeder{ seed, stream };
+			for (auto& word : m_state)
+				word = seeder();
+		}
+
+		result_type operator()()
+		{
+			std::uint64_t result{ std::rotl(m_state[1] * 5, 7) * 9 };
+			std::uint64_t t{ m_state[1] << 17 };
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+			m_state[2] ^= t;
+			m_state[3] = std::rotl(m_state[3], 45);
+			return result;
+		}
+
+		void discard(unsigned long long n)
+		{
+			for (; n > 0; --n)
+				(*this)();
+		}
+	};
+
+	// Philox4x32-10: a counter-based random number generator.
+	//
+	// Instead of stepping an internal state from one value to the next (like std::mt19937), Philox scrambles a 128-bit
+	// counter with a 64-bit key through 10 rounds of multiplications, and each counter value gives 4 random 32-bit
+	// values.  That means we can jump straight to any point in the sequence: skip(n) just adds to the counter.  And each
+	// of the 2^64 streams (the high half of the counter) is independent, so giving every unit of work its own stream,
+	// e.g. stream(handNumber), makes a parallel simulation produce the same results however the work is split between
+	// threads, or what order it runs in.
+	//
+	// Its state is tiny (32 bytes), and it passes the BigCrush statistical tests.
+	// See Salmon et al, "Parallel Random Numbers: As Easy as 1, 2, 3" (2011).
+	//
+	// Sample call: Random::Philox4x32 rng{ 42, handNumber }; // seed 42, stream handNumber
+	// Sample call: Random::get(rng, 0, 51);
+	class Philox4x32
+	{
+	public:
+		using result_type = std::uint32_t;
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	private:
+		std::uint32_t m_key[2]{};
+		std::uint32_t m_counter[4]{}; // [0] and [1] count blocks within the stream, [2] and [3] hold the stream id
+		std::uint32_t m_output[4]{};
+		unsigned int m_next{ 4 };     // index of the next value in m_output (4 means we need a new block)
+
+		static void round(std::uint32_t (&c)[4], const std::uint32_t (&k)[2])
+		{
+			constexpr std::uint64_t m0{ 0xD2511F53 };
+			constexpr std::uint64_t m1{ 0xCD9E8D57 };
+
+			std::uint64_t p0{ m0 * c[0] };
+			std::uint64_t p1{ m1 * c[2] };
+			std::uint32_t next[4]{
+				static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0], static_cast<std::uint32_t>(p1),
+				static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1], static_cast<std::uint32_t>(p0) };
+
+			for (int i{ 0 }; i < 4; ++i)
+				c[i] = next[i];
+		}
+
+		// All 10 rounds: turns a counter (in c) into 4 random values (also in c)
+		static void rounds(std::uint32_t (&c)[4], std::uint32_t k0, std::uint32_t k1)
+		{
+			std::uint32_t k[2]{ k0, k1 };
+			for (int r{ 0 }; r < 10; ++r)
+			{
+				if (r > 0)
+				{
+					k[0] += 0x9E3779B9; // the golden ratio
+					k[1] += 0xBB67AE85; // sqrt(3) - 1
+				}
+				round(c, k);
+			}
+		}
+
+		void generateBlock()
+		{
+			std::uint32_t c[4]{ m_counter[0], m_counter[1], m_counter[2], m_counter[3] };
+			rounds(c, m_key[0], m_key[1]);
+
+			for (int i{ 0 }; i < 4; ++i)
+				m_output[i] = c[i];
+
+			// Move on to the next block (carrying into m_counter[1], but never into the stream id)
+			if (++m_counter[0] == 0)
+				++m_counter[1];
+		}
+
+		std::uint64_t blockIndex() const { return (static_cast<std::uint64_t>(m_counter[1]) << 32) | m_counter[0]; }
+
+		void setBlockIndex(std::uint64_t block)
+		{
+			m_counter[0] = static_cast<std::uint32_t>(block);
+			m_counter[1] = static_cast<std::uint32_t>(block >> 32);
+		}
+
+	public:
+		explicit Philox4x32(std::uint64_t seed = masterSeed(), std::uint64_t streamId = 0)
+			: m_key{ static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) }
+		{
+			stream(streamId);
+		}
+
+		// Switches to the start of the given stream
+		void stream(std::uint64_t id)
+		{
+			m_counter[0] = 0;
+			m_counter[1] = 0;
+			m_counter[2] = static_cast<std::uint32_t>(id);
+			m_counter[3] = static_cast<std::uint32_t>(id >> 32);
+			m_next = 4;
+		}
+
+		// Skips the next n values of the current stream, in constant time
+		void skip(std::uint64_t n)
+		{
+			// Where we are in the stream, counted in values: the block we'd generate next, minus what's left of this one
+			std::uint64_t position{ blockIndex() * 4 - (4 - m_next) + n };
+			setBlockIndex(position / 4);
+			m_next = 4;
+
+			// If we're now part way through a block, generate it and step over the skipped values
+			if (unsigned int offset{ static_cast<unsigned int>(position % 4) }; offset != 0)
+			{
+				generateBlock();
+				m_next = offset;
+			}
+		}
+
+		// The standard name for skip(), so Philox4x32 can stand in for a standard library engine (e.g. behind Random::mt)
+		void discard(unsigned long long n)
+		{
+			skip(n);
+		}
+
+		result_type operator()()
+		{
+			if (m_next == 4)
+			{
+				generateBlock();
+				m_next = 0;
+			}
+			return m_output[m_next++];
+		}
+
+		// Returns the 4 random values for any counter and key directly, without a generator object (so without
+		// touching the master seed)
+		static std::array<std::uint32_t, 4> block(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key)
+		{
+			std::uint32_t c[4]{ counter[0], counter[1], counter[2], counter[3] };
+			rounds(c, key[0], key[1]);
+			return { c[0], c[1], c[2], c[3] };
+		}
+	};
+
+	// The generator behind Random::mt (and Random::get).
+	//
+	// It's a std::mt19937 unless RANDOM_ENGINE is defined (e.g. -DRANDOM_ENGINE=Random::Pcg32, or with CMake,
+	// target_compile_definitions(MyProgram PRIVATE RANDOM_ENGINE=Random::Pcg32)).  Random::mt keeps its name either way.
+	// Any of the generators above can be used (Random_Benchmarks builds a test program with each of them), as can the
+	// standard library's engines.
+#ifdef RANDOM_ENGINE
+	using Engine = RANDOM_ENGINE;
+#else
+	using Engine = std::mt19937;
+#endif
+
+	namespace detail
+	{
+		// Standard library engines are seeded through a std::seed_seq, ours directly from the seed and stream
+		template <typename E>
+		E seeded(std::uint64_t stream)
+		{
+			if constexpr (std::is_constructible_v<E, std::uint64_t, std::uint64_t>)
+				return E{ masterSeed(), stream };
+			else
+			{
+				std::uint64_t master{ masterSeed() };
+				std::seed_seq ss{
+					static_cast<std::seed_seq::result_type>(master), static_cast<std::seed_seq::result_type>(master >> 32),
+					static_cast<std::seed_seq::result_type>(stream), static_cast<std::seed_seq::result_type>(stream >> 32) };
+
+				return E{ ss };
+			}
+		}
+	}
+
+	// Returns a Mersenne Twister seeded from the master seed and the given stream number
 	// Note: we'd prefer to return a std::seed_seq (to initialize a std::mt19937), but std::seed can't be copied, so it can't be returned by value.
 	// Instead, we'll create a std::mt19937, seed it, and then return the std::mt19937 (which can be copied).
-	inline std::mt19937 generate()
+	inline std::mt19937 generate(std::uint64_t stream = 0)
+	{
+		return detail::seeded<std::mt19937>(stream);
+	}
+
+	// Random::mt is created and seeded lazily, the first time a number is drawn, so a program that includes Random.h
+	// but never uses it doesn't pay for seeding at startup.
+	//
+	// It is also reseeded automatically in the child process after a fork(), so that a parent's children don't all
+	// draw the same numbers as each other (and as the parent).  Each child gets its own stream, chosen by how many
+	// times its parent had forked, so with a fixed seed (see above) the children's numbers are reproducible too.  This
+	// works from the moment the program starts, so it doesn't matter whether the parent had used Random::mt yet.
+	//
+	// In thread-local mode (define RANDOM_THREAD_LOCAL), every thread gets its own generator, so threads can call
+	// Random::get at the same time without a data race (and without fighting over a lock).  Each thread's generator is
+	// seeded from the master seed plus a thread index (used as the stream number).  By default the index is the order
+	// in which threads first use Random, which can vary from run to run.  A thread that needs a particular stream (e.g.
+	// worker i of a simulation) can call seedThread(i) before drawing numbers.
+	namespace detail
 	{
-		std::random_device rd{};
+		// Counts fork()s made by this process, and identifies which child of which parent we are
+		inline std::uint64_t forkCount{ 0 };
+		inline std::uint64_t lineage{ 0 };
+
+		// Bumped in the child after every fork(); engines check it to know they need reseeding
+		inline std::atomic<unsigned int> forkGeneration{ 0 };
+
+		// The process that lineage belongs to.  A child whose fork() didn't run the handlers below (e.g. one made with a
+		// raw clone() system call) still has its parent's.  watchForks() compares it with getpid(), but only when the
+		// master seed is chosen or Random::mt is reseeded (getpid() is a system call, too slow for every number drawn),
+		// so such a child only gets its own stream if its parent hadn't used Random::mt yet.  (A vfork() child may only
+		// call exec or _exit, so it mustn't use Random at all.)
+		inline long lineagePid{ 0 };
+
+		inline void forked(std::uint64_t count)
+		{
+			lineage = SplitMix64::mix(lineage + count * 0x9E3779B97F4A7C15);
+			forkCount = 0;
+#if defined(__unix__) || defined(__APPLE__)
+			lineagePid = static_cast<long>(getpid());
+#endif
+			forkGeneration.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline bool registerForkHandlers()
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			lineagePid = static_cast<long>(getpid());
+			pthread_atfork(
+				[] { ++forkCount; },        // in the parent, just before the fork
+				nullptr,
+				[] { forked(forkCount); }); // in the child
+#endif
+			return true;
+		}
+
+		// Called when the program starts, when the master seed is chosen, and whenever Random::mt is (re)seeded, so it
+		// isn't on the path of every number drawn
+		inline void watchForks()
+		{
+			static const bool s_registered{ registerForkHandlers() };
+			(void)s_registered;
+
+#if defined(__unix__) || defined(__APPLE__)
+			// We can't know how many times the parent had forked, so the child's own process id picks its stream
+			if (auto pid{ static_cast<long>(getpid()) }; pid != lineagePid) [[unlikely]]
+				forked(static_cast<std::uint64_t>(pid));
+#endif
+		}
+
+		// Registers the fork handlers before main() runs, so a child forked before the parent first uses Random still
+		// gets a lineage of its own (otherwise, with a fixed seed, every such child would draw the same numbers)
+		inline const bool watchingForks{ (watchForks(), true) };
+
+		// The stream a thread's generator should use (the parent process uses the thread index as it is)
+		inline std::uint64_t streamFor(std::uint64_t threadIndex)
+		{
+			watchForks();
+			return (lineage == 0) ? threadIndex : SplitMix64::mix(lineage + threadIndex);
+		}
+
+		struct EngineState
+		{
+			Engine engine;
+			std::uint64_t threadIndex{};
+			unsigned int generation{};
+
+			explicit EngineState(std::uint64_t index)
+				: engine{ seeded<Engine>(streamFor(index)) }
+				, threadIndex{ index }
+				, generation{ forkGeneration.load(std::memory_order_relaxed) }
+			{
+			}
+		};
+
+#ifdef RANDOM_THREAD_LOCAL
+		inline std::atomic<std::uint64_t> nextThreadIndex{ 0 };
+#endif
 
-		// Create seed_seq with clock and 7 random numbers from std::random_device
-		std::seed_seq ss{
-			static_cast<std::seed_seq::result_type>(std::chrono::steady_clock::now().time_since_epoch().count()),
-				rd(), rd(), rd(), rd(), rd(), rd(), rd() };
+		// Returns the generator behind Random::mt (in thread-local mode, the calling thread's own one)
+		inline EngineState& engineState()
+		{
+#ifdef RANDOM_THREAD_LOCAL
+			thread_local EngineState s_state{ nextThreadIndex++ };
+#else
+			static EngineState s_state{ 0 };
+#endif
 
-		return std::mt19937{ ss };
+			if (s_state.generation != forkGeneration.load(std::memory_order_relaxed)) [[unlikely]]
+			{
+				s_state.engine = seeded<Engine>(streamFor(s_state.threadIndex));
+				s_state.generation = forkGeneration.load(std::memory_order_relaxed);
+			}
+
+			return s_state;
+		}
+
+		inline Engine& engine()
+		{
+			return engineState().engine;
+		}
+
+		inline void reseedEngine(std::uint64_t threadIndex)
+		{
+			EngineState& state{ engineState() };
+			state.threadIndex = threadIndex;
+			state.engine = seeded<Engine>(streamFor(threadIndex));
+		}
 	}
 
-	// Here's our global std::mt19937 object.
+	// Random::mt used to be the std::mt19937 itself.  Now it is a small handle that can be used in exactly the same
+	// ways (e.g. std::shuffle(v.begin(), v.end(), Random::mt), or die6(Random::mt)), and forwards to the real
+	// generator, which is only created the first time it is needed.
+	class LazyEngine
+	{
+	public:
+		using result_type = Engine::result_type;
+
+		static constexpr result_type min() { return Engine::min(); }
+		static constexpr result_type max() { return Engine::max(); }
+
+		result_type operator()() { return detail::engine()(); }
+		void discard(unsigned long long n) { detail::engine().discard(n); }
+	};
+
+	// Here's our global Random::mt object.
 	// The inline keyword means we only have one global instance for our whole program.
-	inline std::mt19937 mt{ generate() }; // generates a seeded std::mt19937 and copies it into our global object
+	// Note: unless RANDOM_THREAD_LOCAL is defined, it isn't safe to use from more than one thread at a time.
+	inline LazyEngine mt{};
+
+#ifdef RANDOM_THREAD_LOCAL
+	// Reseeds the calling thread's generator as thread number threadIndex, so it draws the same numbers every run
+	// (for the same master seed) no matter which order the threads started in
+	inline void seedThread(std::uint64_t threadIndex)
+	{
+		detail::reseedEngine(threadIndex);
+	}
+#endif
+
+	// Replaces the master seed, and reseeds Random::mt from it (in thread-local mode, the calling thread's generator,
+	// as thread 0).  Call this before starting any other threads.
+	inline void reseed(std::uint64_t seed)
+	{
+		detail::logSeed = false; // so we don't print the random seed this one replaces, either
+		detail::seedStorage() = seed;
+		detail::reseedEngine(0);
+	}
+
+	// Fast bounded random numbers, used by get() below.
+	//
+	// std::uniform_int_distribution has to be constructed on every call, and (in libstdc++) uses a division to reject
+	// the values that would make some results more likely than others.  Lemire's "nearly divisionless" method does the
+	// same job with a multiplication: multiply a random 32-bit value x by the number of possible results s, and the top
+	// 32 bits of the 64-bit product are a number in [0, s).  Only when the bottom 32 bits are small enough that the
+	// result might be biased do we need a division, to find the exact threshold, and that is rare for small s.
+	// See Daniel Lemire, "Fast Random Integer Generation in an Interval" (2019).
+	namespace detail
+	{
+		// The fast path needs an engine producing uniformly random 32-bit or 64-bit values (e.g. std::mt19937, std::mt19937_64)
+		template <typename Engine>
+		constexpr bool fullWidth { Engine::min() == 0
+			&& (Engine::max() == std::numeric_limits<std::uint32_t>::max() || Engine::max() == std::numeric_limits<std::uint64_t>::max()) };
+
+		// A random 32-bit value.  Other engines (e.g. std::minstd_rand, whose values are in [1, 2^31 - 2]) would leave
+		// most of the bits empty, so std::uniform_int_distribution stitches their values together instead.
+		template <typename Engine>
+		std::uint32_t next32(Engine& engine)
+		{
+			if constexpr (!fullWidth<Engine>)
+				return std::uniform_int_distribution<std::uint32_t>{}(engine);
+			else if constexpr (Engine::max() == std::numeric_limits<std::uint32_t>::max())
+				return static_cast<std::uint32_t>(engine());
+			else
+				return static_cast<std::uint32_t>(engine() >> 32); // the high bits are the best ones in some engines
+		}
+
+		// A random 64-bit value (likewise)
+		template <typename Engine>
+		std::uint64_t next64(Engine& engine)
+		{
+			if constexpr (!fullWidth<Engine>)
+				return std::uniform_int_distribution<std::uint64_t>{}(engine);
+			else if constexpr (Engine::max() == std::numeric_limits<std::uint32_t>::max())
+				return (static_cast<std::uint64_t>(engine()) << 32) | static_cast<std::uint32_t>(engine());
+			else
+				return static_cast<std::uint64_t>(engine());
+		}
+
+		// Returns a random number between [0, range] (inclusive)
+		template <typename Engine>
+		std::uint32_t bounded32(Engine& engine, std::uint32_t range)
+		{
+			if (range == std::numeric_limits<std::uint32_t>::max())
+				return next32(engine);
+
+			std::uint32_t s{ range + 1 };
+			std::uint64_t m{ static_cast<std::uint64_t>(next32(engine)) * s };
+			auto low{ static_cast<std::uint32_t>(m) };
+			if (low < s)
+			{
+				std::uint32_t threshold{ static_cast<std::uint32_t>(-s) % s }; // 2^32 mod s
+				while (low < threshold)
+				{
+					m = static_cast<std::uint64_t>(next32(engine)) * s;
+					low = static_cast<std::uint32_t>(m);
+				}
+			}
+
+			return static_cast<std::uint32_t>(m >> 32);
+		}
+
+#ifdef __SIZEOF_INT128__
+		// The same, with a 128-bit product (a GCC and Clang extension, hence __extension__ to keep -Wpedantic quiet)
+		__extension__ typedef unsigned __int128 Uint128;
+
+		template <typename Engine>
+		std::uint64_t bounded64(Engine& engine, std::uint64_t range)
+		{
+			if (range == std::numeric_limits<std::uint64_t>::max())
+				return next64(engine);
+
+			std::uint64_t s{ range + 1 };
+			Uint128 m{ static_cast<Uint128>(next64(engine)) * s };
+			auto low{ static_cast<std::uint64_t>(m) };
+			if (low < s)
+			{
+				std::uint64_t threshold{ (0 - s) % s }; // 2^64 mod s
+				while (low < threshold)
+				{
+					m = static_cast<Uint128>(next64(engine)) * s;
+					low = static_cast<std::uint64_t>(m);
+				}
+			}
+
+			return static_cast<std::uint64_t>(m >> 64);
+		}
+#endif
+
+		// Returns a random value between [min, max] (inclusive) from the given engine
+		template <typename T, typename Engine>
+		T uniform(Engine& engine, T min, T max)
+		{
+			static_assert(std::is_integral_v<T>, "Random::get only supports integral types");
+
+			// Work in the unsigned type of the same size, so max - min can't overflow, then shift back up by min
+			using U = std::make_unsigned_t<T>;
+			auto range{ static_cast<U>(static_cast<U>(max) - static_cast<U>(min)) };
+
+			if constexpr (!fullWidth<Engine>)
+				return std::uniform_int_distribution<T>{ min, max }(engine);
+			else if constexpr (sizeof(U) <= sizeof(std::uint32_t))
+				return static_cast<T>(static_cast<U>(static_cast<U>(min) + bounded32(engine, range)));
+#ifdef __SIZEOF_INT128__
+			else if (range <= std::numeric_limits<std::uint32_t>::max()) // e.g. an index into a std::vector
+				return static_cast<T>(static_cast<U>(min) + bounded32(engine, static_cast<std::uint32_t>(range)));
+			else
+				return static_cast<T>(static_cast<U>(min) + bounded64(engine, range));
+#else
+			else
+				return std::uniform_int_distribution<T>{ min, max }(engine);
+#endif
+		}
+	}
 
 	// Generate a random int between [min, max] (inclusive)
         // * also handles cases where the two arguments have different types but can be converted to int
 	inline int get(int min, int max)
 	{
-		return std::uniform_int_distribution{min, max}(mt);
+		return detail::uniform(detail::engine(), min, max);
 	}
 
 	// The following function templates can be used to generate random numbers in other cases
@@ -52,7 +717,7 @@ namespace Random
 	template <typename T>
 	T get(T min, T max)
 	{
-		return std::uniform_int_distribution<T>{min, max}(mt);
+		return detail::uniform(detail::engine(), min, max);
 	}
 
 	// Generate a random value between [min, max] (inclusive)
@@ -67,6 +732,596 @@ namespace Random
 	{
 		return get<R>(static_cast<R>(min), static_cast<R>(max));
 	}
+
+	// Generate a random value between [min, max] (inclusive) from a generator of your own
+	// * works with any generator, e.g. std::mt19937_64 or Random::Philox4x32
+	// Sample call: Random::get(rng, 1, 6);          // returns int
+	template <typename Engine, typename T>
+	T get(Engine& engine, T min, T max)
+	{
+		return detail::uniform(engine, min, max);
+	}
+
+	// Shuffling: a Fisher-Yates shuffle that gets several random indices out of each 64-bit random value.
+	//
+	// Shuffling n items needs a random index in [0, n), then one in [0, n - 1), and so on.  std::shuffle makes (at
+	// best) two of them from each value it draws, with a division for each pair.  But if we multiply a random 64-bit
+	// value by n, the top 64 bits of the 128-bit product are an index in [0, n), and the bottom 64 bits are still
+	// random, so we can multiply those by n - 1 to get the next index, and so on, as long as the product of the ranges
+	// fits in 64 bits.  A deck of 52 cards takes only 5 random 64-bit values this way, instead of 26 32-bit ones.  As
+	// in bounded64(), a division is only needed (to check for bias) when what's left at the end is smaller than that
+	// product, so we keep the product below 2^56 to make that rare (1 time in 256 at most).
+	// See Brackett-Luescher and Lemire, "Batched Ranged Random Integer Generation" (2024).
+	//
+	// Sample call: Random::shuffle(deck);                    // a std::array, using Random::mt
+	// Sample call: Random::shuffle(v.begin(), v.end(), rng); // any random access range, using a generator of your own
+	namespace detail
+	{
+		constexpr std::size_t maxShuffleBatch{ 16 };
+		constexpr int maxShuffleBits{ 56 };
+
+		// One random value's worth of a shuffle: swaps items n - 1 down to n - count with a random item below each
+		struct ShuffleBatch
+		{
+			std::uint64_t n{};
+			std::size_t count{};
+		};
+
+#ifdef __SIZEOF_INT128__
+		// If n fits in b bits, n * (n - 1) * ... fits in 56 bits for 56 / b ranges, so that's how many we take
+		constexpr ShuffleBatch shuffleBatch(std::uint64_t n)
+		{
+			auto bits{ static_cast<std::size_t>(std::bit_width(n)) };
+			std::size_t count{ std::min({ maxShuffleBatch, static_cast<std::size_t>(maxShuffleBits) / bits, static_cast<std::size_t>(n - 1) }) };
+			return { n, std::max(count, std::size_t{ 1 }) };
+		}
+
+		// Count is a template parameter so that the loops below are unrolled
+		template <std::size_t Count, typename RandomIt, typename Engine>
+		void shuffle(RandomIt first, std::uint64_t n, Engine& engine)
+		{
+			std::uint64_t indices[Count]{};
+			auto split{ [&](std::uint64_t r) {
+				for (std::size_t j{ 0 }; j < Count; ++j)
+				{
+					Uint128 m{ static_cast<Uint128>(r) * (n - j) };
+					indices[j] = static_cast<std::uint64_t>(m >> 64);
+					r = static_cast<std::uint64_t>(m);
+				}
+				return r;
+			} };
+
+			// The product of the ranges is below 2^56 (or is n itself, for a batch of one), so most of the time what's
+			// left over is too big for there to be any bias, and we don't even need to work out the product
+			std::uint64_t leftover{ split(next64(engine)) };
+			std::uint64_t bound{ (Count == 1) ? n : std::uint64_t{ 1 } << maxShuffleBits };
+			if (leftover < bound) [[unlikely]]
+			{
+				std::uint64_t product{ 1 };
+				for (std::size_t j{ 0 }; j < Count; ++j)
+					product *= n - j;
+
+				std::uint64_t threshold{ (0 - product) % product }; // 2^64 mod product
+				while (leftover < threshold)
+					leftover = split(next64(engine));
+			}
+
+			using Difference = typename std::iterator_traits<RandomIt>::difference_type;
+			for (std::size_t j{ 0 }; j < Count; ++j)
+				std::iter_swap(first + static_cast<Difference>(n - 1 - j), first + static_cast<Difference>(indices[j]));
+		}
+
+		// Calls shuffle<batch.count>
+		template <typename RandomIt, typename Engine>
+		void shuffle(RandomIt first, const ShuffleBatch& batch, Engine& engine)
+		{
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				(void)((batch.count == I + 1 && (shuffle<I + 1>(first, batch.n, engine), true)) || ...);
+			}(std::make_index_sequence<maxShuffleBatch>{});
+		}
+
+		// For a std::array, the batches only depend on its size, so they can be worked out at compile time
+		template <std::size_t N>
+		consteval std::size_t shuffleBatchCount()
+		{
+			std::size_t batches{ 0 };
+			for (std::uint64_t n{ N }; n > 1; n -= shuffleBatch(n).count)
+				++batches;
+			return batches;
+		}
+
+		template <std::size_t N>
+		consteval std::array<ShuffleBatch, shuffleBatchCount<N>()> shufflePlan()
+		{
+			std::array<ShuffleBatch, shuffleBatchCount<N>()> plan{};
+			std::uint64_t n{ N };
+			for (auto& batch : plan)
+			{
+				batch = shuffleBatch(n);
+				n -= batch.count;
+			}
+			return plan;
+		}
+#endif
+	}
+
+	// Shuffles [first, last) using a generator of your own
+	template <std::random_access_iterator RandomIt, typename Engine>
+	void shuffle(RandomIt first, RandomIt last, Engine& engine)
+	{
+#ifdef __SIZEOF_INT128__
+		if constexpr (detail::fullWidth<Engine>)
+		{
+			for (auto n{ static_cast<std::uint64_t>(last - first) }; n > 1;)
+			{
+				detail::ShuffleBatch batch{ detail::shuffleBatch(n) };
+				detail::shuffle(first, batch, engine);
+				n -= batch.count;
+			}
+			return;
+		}
+#endif
+		std::shuffle(first, last, engine);
+	}
+
+	// Shuffles a std::array using a generator of your own
+	template <typename T, std::size_t N, typename Engine>
+	void shuffle(std::array<T, N>& values, Engine& engine)
+	{
+#ifdef __SIZEOF_INT128__
+		if constexpr (detail::fullWidth<Engine>)
+		{
+			// Every batch size is a constant, so the compiler can unroll all of it
+			static constexpr auto plan{ detail::shufflePlan<N>() };
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				(detail::shuffle<plan[I].count>(values.begin(), plan[I].n, engine), ...);
+			}(std::make_index_sequence<plan.size()>{});
+			return;
+		}
+#endif
+		std::shuffle(values.begin(), values.end(), engine);
+	}
+
+	// Shuffles a std::array using Random::mt
+	template <typename T, std::size_t N>
+	void shuffle(std::array<T, N>& values)
+	{
+		shuffle(values, detail::engine());
+	}
+
+	// Fast random floating point numbers.
+	//
+	// uniform01() takes the top 53 bits of a random 64-bit value (a double has 53 bits of precision) and scales them
+	// into [0, 1) with a multiplication by 2^-53, which is exact.  std::uniform_real_distribution (via
+	// std::generate_canonical) divides instead, and checks whether rounding gave it 1.0.
+	//
+	// normal() uses the ziggurat method (Marsaglia and Tsang, 2000, with Doornik's 2005 improvements).  The area under
+	// the bell curve is covered by 256 stacked rectangles of equal area, plus a tail.  We pick a rectangle with the low
+	// 8 bits of one random value, and a point across it with the top 53 bits.  About 99% of the time the point lies
+	// inside the part of the rectangle that is entirely under the curve, so the result is just a table lookup and a
+	// multiplication.  Only the other 1% need std::exp (or std::log, for the tail).  std::normal_distribution uses the
+	// polar method, which needs two uniform values, a std::log and a std::sqrt for every pair of results.
+	//
+	// For filling a whole array with values, see fillUniform01() and fillNormal() in RandomFill.h (which is kept with
+	// the lesson's copy of Random.h, in Section_08/Global_Random_Numbers_Random_h).
+	namespace detail
+	{
+		template <typename Engine>
+		double uniform01(Engine& engine)
+		{
+			return static_cast<double>(next64(engine) >> 11) * 0x1.0p-53;
+		}
+
+		struct Ziggurat
+		{
+			static constexpr std::size_t layers{ 256 };
+			static constexpr double r{ 3.6541528853610088 };       // where the tail starts
+			static constexpr double area{ 0.00492867323399 };      // of each layer (and of the base, including the tail)
+
+			double x[layers + 1]{}; // right edge of each layer; x[0] is the base's width if it were a rectangle
+			double ratio[layers]{}; // x[i + 1] / x[i]: the part of layer i that is entirely under the curve
+
+			Ziggurat()
+			{
+				double f{ std::exp(-0.5 * r * r) };
+				x[0] = area / f;
+				x[1] = r;
+				for (std::size_t i{ 2 }; i < layers; ++i)
+				{
+					x[i] = std::sqrt(-2.0 * std::log(area / x[i - 1] + f));
+					f = std::exp(-0.5 * x[i] * x[i]);
+				}
+				x[layers] = 0.0;
+
+				for (std::size_t i{ 0 }; i < layers; ++i)
+					ratio[i] = x[i + 1] / x[i];
+			}
+		};
+
+		inline const Ziggurat& ziggurat()
+		{
+			static const Ziggurat s_ziggurat{};
+			return s_ziggurat;
+		}
+
+		// A standard normal value beyond r (or below -r)
+		template <typename Engine>
+		double normalTail(Engine& engine, bool negative)
+		{
+			double x{};
+			double y{};
+			do
+			{
+				// 1 - uniform01() is in (0, 1], so we never take the log of 0
+				x = std::log(1.0 - uniform01(engine)) / Ziggurat::r;
+				y = std::log(1.0 - uniform01(engine));
+			} while (-2.0 * y < x * x);
+
+			return negative ? x - Ziggurat::r : Ziggurat::r - x;
+		}
+
+		// A standard normal value, starting from the random 64-bit value bits (more are drawn from engine if needed)
+		template <typename Engine>
+		double normal(std::uint64_t bits, Engine& engine)
+		{
+			const Ziggurat& z{ ziggurat() };
+
+			while (true)
+			{
+				auto i{ static_cast<std::size_t>(bits & (Ziggurat::layers - 1)) };
+				// The top 53 bits as a signed number, scaled into [-1, 1)
+				double u{ static_cast<double>(static_cast<std::int64_t>(bits) >> 11) * 0x1.0p-52 };
+
+				if (std::abs(u) < z.ratio[i]) [[likely]]
+					return u * z.x[i];
+
+				if (i == 0)
+					return normalTail(engine, u < 0.0);
+
+				// Between the curve and the next layer's edge: accept x with probability proportional to the curve there
+				double x{ u * z.x[i] };
+				double f0{ std::exp(-0.5 * (z.x[i] * z.x[i] - x * x)) };
+				double f1{ std::exp(-0.5 * (z.x[i + 1] * z.x[i + 1] - x * x)) };
+				if (f1 + uniform01(engine) * (f0 - f1) < 1.0)
+					return x;
+
+				bits = next64(engine);
+			}
+		}
+	}
+
+	// Generate a random double in [0, 1)
+	inline double uniform01()
+	{
+		return detail::uniform01(detail::engine());
+	}
+
+	// Generate a random double in [0, 1) from a generator of your own
+	template <std::uniform_random_bit_generator Engine>
+	double uniform01(Engine& engine)
+	{
+		return detail::uniform01(engine);
+	}
+
+	// Generate a normally distributed random double (by default with mean 0 and standard deviation 1)
+	// Sample call: Random::normal(100.0, 0.5);      // e.g. a tower height measured to within about half a meter
+	inline double normal(double mean = 0.0, double stddev = 1.0)
+	{
+		auto& engine{ detail::engine() };
+		return mean + stddev * detail::normal(detail::next64(engine), engine);
+	}
+
+	// Generate a normally distributed random double from a generator of your own
+	template <std::uniform_random_bit_generator Engine>
+	double normal(Engine& engine, double mean = 0.0, double stddev = 1.0)
+	{
+		return mean + stddev * detail::normal(detail::next64(engine), engine);
+	}
+
+	// Weighted random choices: AliasTable picks an index i with probability weights[i] / (sum of all the weights).
+	//
+	// Walker's alias method (as improved by Vose, 1991).  Imagine n columns, one per index, each as tall as the
+	// average weight.  Indices with less than the average weight don't fill their column, so the rest of it is given
+	// to one index with more than the average (its "alias").  Afterwards every column holds at most two indices, so a
+	// draw only needs to pick a column uniformly, then toss a biased coin to choose between the column's own index and
+	// its alias.  That's O(1) per draw, whatever the number of weights, where std::discrete_distribution does a binary
+	// search.  Building the table is O(n).
+	//
+	// Sample call: Random::AliasTable spawnRates{ 1.0, 20.0, 8.0 }; // index 1 is 20 times as likely as index 0
+	// Sample call: spawnRates();                                    // draws an index using Random::mt
+	// Sample call: spawnRates.draw(std::span{ indices });           // fills a std::vector<int> with indices
+	class AliasTable
+	{
+	public:
+		struct Column
+		{
+			std::uint32_t threshold{}; // keep this column's own index if a random 32-bit value is below this
+			std::uint32_t alias{};
+		};
+
+	private:
+		std::vector<Column> m_columns{};
+
+		// Tosses column's coin
+		template <std::uniform_random_bit_generator Engine>
+		std::size_t pick(Engine& engine, std::uint32_t column) const
+		{
+			return (detail::next32(engine) < m_columns[column].threshold) ? column : m_columns[column].alias;
+		}
+
+	public:
+		AliasTable() = default;
+
+		// weights can be any range of non-negative numbers (e.g. a std::vector<double> or a C-style array of int),
+		// and mustn't all be zero
+		template <std::ranges::input_range R>
+			requires std::is_arithmetic_v<std::ranges::range_value_t<R>>
+		explicit AliasTable(const R& weights)
+		{
+			std::vector<double> scaled{};
+			double total{ 0.0 };
+			for (auto w : weights)
+			{
+				assert(w >= 0 && "AliasTable weights can't be negative");
+				scaled.push_back(static_cast<double>(w));
+				total += static_cast<double>(w);
+			}
+
+			assert(!scaled.empty() && total > 0.0 && "AliasTable needs at least one positive weight");
+			assert(scaled.size() <= std::numeric_limits<std::uint32_t>::max());
+
+			// Scale the weights so the average is 1, and sort the columns into those that are under- and over-full
+			auto n{ static_cast<std::uint32_t>(scaled.size()) };
+			std::vector<std::uint32_t> small{};
+			std::vector<std::uint32_t> large{};
+			for (std::uint32_t i{ 0 }; i < n; ++i)
+			{
+				scaled[i] *= n / total;
+				(scaled[i] < 1.0 ? small : large).push_back(i);
+			}
+
+			// Top up each under-full column from an over-full one, which may then become under-full itself
+			m_columns.resize(n);
+			while (!small.empty() && !large.empty())
+			{
+				std::uint32_t less{ small.back() };
+				small.pop_back();
+				std::uint32_t more{ large.back() };
+
+				m_columns[less] = { static_cast<std::uint32_t>(scaled[less] * 0x1.0p32), more };
+
+				scaled[more] -= 1.0 - scaled[less];
+				if (scaled[more] < 1.0)
+				{
+					large.pop_back();
+					small.push_back(more);
+				}
+			}
+
+			// Whatever is left is full (give or take rounding errors), so it never needs its alias
+			for (std::uint32_t i : large)
+				m_columns[i] = { std::numeric_limits<std::uint32_t>::max(), i };
+			for (std::uint32_t i : small)
+				m_columns[i] = { std::numeric_limits<std::uint32_t>::max(), i };
+		}
+
+		AliasTable(std::initializer_list<double> weights)
+			: AliasTable{ std::span<const double>{ weights.begin(), weights.size() } }
+		{
+		}
+
+		// The number of weights (draws are in [0, size() - 1]).  A default-constructed table has none, and can't be drawn
+		// from until another table is assigned to it.
+		std::size_t size() const { return m_columns.size(); }
+
+		const std::vector<Column>& columns() const { return m_columns; }
+
+		// Draws a random index, using Random::mt
+		std::size_t operator()() const
+		{
+			return (*this)(detail::engine());
+		}
+
+		// Draws a random index, using a generator of your own
+		template <std::uniform_random_bit_generator Engine>
+		std::size_t operator()(Engine& engine) const
+		{
+			assert(size() > 0 && "Can't draw from an empty AliasTable");
+			return pick(engine, detail::bounded32(engine, static_cast<std::uint32_t>(m_columns.size() - 1)));
+		}
+
+		// Fills indices with random indices.  (For millions of them, Random::fill(indices, table) is faster.  It is in
+		// RandomFill.h, next to the lesson's copy of Random.h in Section_08/Global_Random_Numbers_Random_h.)
+		template <std::integral T, std::uniform_random_bit_generator Engine>
+		void draw(std::span<T> indices, Engine& engine) const
+		{
+			assert(size() > 0 && "Can't draw from an empty AliasTable");
+			auto range{ static_cast<std::uint32_t>(m_columns.size() - 1) };
+			for (T& index : indices)
+				index = static_cast<T>(pick(engine, detail::bounded32(engine, range)));
+		}
+
+		template <std::integral T>
+		void draw(std::span<T> indices) const
+		{
+			draw(indices, detail::engine());
+		}
+	};
+
+	// Random samples without replacement: k different items chosen at random from a bigger collection.
+	//
+	// The obvious way is to copy the whole collection and shuffle it, then keep the first k items, but that's O(n) in
+	// time and memory however small k is.
+	//
+	// If we can index into the collection (e.g. a std::vector), sample() uses Floyd's algorithm, which picks k
+	// different indices with just k random numbers.  For j = n - k up to n - 1, it picks an index t in [0, j], and
+	// takes t unless it already has it, in which case it takes j (which it can't already have).
+	// See Bentley and Floyd, "A Sample of Brilliance" (1987).
+	//
+	// If we can only read the items one after another, and don't know how many there will be (e.g. the lines of a
+	// file), ReservoirSampler keeps a random sample of k of the items seen so far.  It uses Li's Algorithm L: rather
+	// than drawing a random number for every item, it works out how many items it can skip before the next one it keeps.
+	// That's about k * log(n / k) random numbers in all, and a program reading a file can skip those items cheaply
+	// (without e.g. creating a std::string for each one).  See Li, "Reservoir-Sampling Algorithms of Time Complexity
+	// O(n(1 + log(N/n)))" (1994).
+	//
+	// Sample call: Random::sample(words, 5);               // 5 different elements of words, in random order
+	// Sample call: Random::ReservoirSampler<std::string> sampler{ 100 };
+	// Sample call: sampler.add(line);                       // for every line of a file, then use sampler.sample()
+	namespace detail
+	{
+		// Floyd's algorithm: k different indices in [0, n), in no particular order
+		template <typename Engine>
+		std::vector<std::size_t> sampleIndices(std::size_t n, std::size_t k, Engine& engine)
+		{
+			std::vector<std::size_t> chosen{};
+			chosen.reserve(k);
+
+			// For a small sample, searching the indices we have so far is quicker than hashing them
+			constexpr std::size_t maxLinearSearch{ 64 };
+			std::unordered_set<std::size_t> seen{};
+			if (k > maxLinearSearch)
+				seen.reserve(k);
+
+			auto have{ [&](std::size_t index) {
+				return (k > maxLinearSearch) ? seen.contains(index)
+					: std::find(chosen.begin(), chosen.end(), index) != chosen.end();
+			} };
+
+			for (std::size_t j{ n - k }; j < n; ++j)
+			{
+				std::size_t t{ uniform(engine, std::size_t{ 0 }, j) };
+				std::size_t index{ have(t) ? j : t };
+				chosen.push_back(index);
+				if (k > maxLinearSearch)
+					seen.insert(index);
+			}
+
+			return chosen;
+		}
+	}
+
+	template <typename T>
+	class ReservoirSampler
+	{
+	private:
+		std::vector<T> m_sample{};
+		std::size_t m_k{};
+		std::uint64_t m_seen{ 0 }; // items added (or skipped) so far
+		std::uint64_t m_next{ 0 }; // the index of the next item we'll keep, once the sample is full
+		double m_w{ 1.0 };         // Algorithm L's W: the largest of k random "keys" in (0, 1) so far
+
+		template <std::uniform_random_bit_generator Engine>
+		void scheduleNext(Engine& engine)
+		{
+			// 1 - uniform01() is in (0, 1], so we never take the log of 0
+			m_w *= std::exp(std::log(1.0 - detail::uniform01(engine)) / static_cast<double>(m_k));
+			double skip{ std::floor(std::log(1.0 - detail::uniform01(engine)) / std::log1p(-m_w)) };
+
+			constexpr auto maxSkip{ static_cast<double>(std::numeric_limits<std::uint64_t>::max() / 2) };
+			m_next = m_seen + ((skip < maxSkip) ? static_cast<std::uint64_t>(skip) : static_cast<std::uint64_t>(maxSkip));
+		}
+
+	public:
+		explicit ReservoirSampler(std::size_t k)
+			: m_k{ k }
+		{
+			m_sample.reserve(k);
+		}
+
+		// Offers the next item, using a generator of your own.  Returns true if it was kept (for now).
+		template <typename U, std::uniform_random_bit_generator Engine>
+		bool add(U&& item, Engine& engine)
+		{
+			if (m_seen < m_k)
+			{
+				m_sample.emplace_back(std::forward<U>(item));
+				if (++m_seen == m_k)
+					scheduleNext(engine);
+				return true;
+			}
+
+			// With k == 0 nothing is ever kept, but the item still counts as seen
+			if (m_k == 0)
+			{
+				++m_seen;
+				return false;
+			}
+
+			if (m_seen++ != m_next)
+				return false;
+
+			m_sample[detail::uniform(engine, std::size_t{ 0 }, m_k - 1)] = T(std::forward<U>(item));
+			scheduleNext(engine);
+			return true;
+		}
+
+		// Offers the next item, using Random::mt
+		template <typename U>
+		bool add(U&& item)
+		{
+			return add(std::forward<U>(item), detail::engine());
+		}
+
+		// How many of the next items would be ignored by add(), so they can be skipped over (with skip()) instead
+		std::uint64_t skipAhead() const
+		{
+			return (m_seen < m_k || m_k == 0) ? 0 : m_next - m_seen;
+		}
+
+		void skip(std::uint64_t count)
+		{
+			assert(count <= skipAhead() && "ReservoirSampler::skip would skip an item it needs");
+			m_seen += count;
+		}
+
+		// The items seen so far (added or skipped)
+		std::uint64_t seen() const { return m_seen; }
+
+		// The sample so far: min(k, seen()) of the items, not in any particular order
+		const std::vector<T>& sample() const& { return m_sample; }
+		std::vector<T> sample() && { return std::move(m_sample); }
+	};
+
+	// Returns k different elements of range (or all of them, if it has fewer than k), in random order, using a
+	// generator of your own
+	template <std::ranges::input_range R, std::uniform_random_bit_generator Engine>
+	std::vector<std::ranges::range_value_t<R>> sample(R&& range, std::size_t k, Engine& engine)
+	{
+		std::vector<std::ranges::range_value_t<R>> result{};
+
+		if constexpr (std::ranges::random_access_range<R> && std::ranges::sized_range<R>)
+		{
+			auto n{ static_cast<std::size_t>(std::ranges::size(range)) };
+			k = std::min(k, n);
+			result.reserve(k);
+			for (std::size_t index : detail::sampleIndices(n, k, engine))
+				result.push_back(std::ranges::begin(range)[static_cast<std::ranges::range_difference_t<R>>(index)]);
+		}
+		else
+		{
+			ReservoirSampler<std::ranges::range_value_t<R>> sampler{ k };
+			for (auto it{ std::ranges::begin(range) }; it != std::ranges::end(range); ++it)
+			{
+				if (sampler.skipAhead() > 0)
+					sampler.skip(1); // without copying the item
+				else
+					sampler.add(*it, engine);
+			}
+			result = std::move(sampler).sample();
+		}
+
+		// Neither algorithm picks its items in a random order
+		shuffle(result.begin(), result.end(), engine);
+		return result;
+	}
+
+	// Returns k different elements of range (or all of them, if it has fewer than k), in random order
+	template <std::ranges::input_range R>
+	std::vector<std::ranges::range_value_t<R>> sample(R&& range, std::size_t k)
+	{
+		return sample(std::forward<R>(range), k, detail::engine());
+	}
 }
 
 #endif
\ No newline at end of file
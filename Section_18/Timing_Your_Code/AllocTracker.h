@@ -0,0 +1,260 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <algorithm> // for std::max
+#include <array>
+#include <atomic>
+#include <cstddef> // for std::size_t, std::max_align_t
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::malloc, std::aligned_alloc, std::free
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <mutex>
+#include <new> // for std::bad_alloc, std::nothrow_t, std::align_val_t
+#include <string_view>
+
+// Counts heap allocations made inside profiling zones (see Profiler.h).
+//
+// Code like IntArray::insertBefore() allocates a new buffer on every call, which is easy to miss when reading the
+// code and hard to see in a timing.  When allocation tracking is on, every allocation made while a PROFILE_SCOPE or
+// PROFILE_FUNCTION zone is open (on that thread) is attributed to that zone: how many allocations, how many bytes,
+// and the peak number of bytes that were live at once.  A summary of every zone is printed when the program exits.
+//
+// This works by replacing the global operator new and operator delete (every form of them, including the
+// std::align_val_t ones used for over-aligned types), which is opt-in: define TRACK_ALLOCATIONS (e.g. via the
+// ENABLE_ALLOCATION_TRACKING CMake option) to turn it on.  Because a program can only have one replacement operator
+// new, only include this header (or Profiler.h) from one .cpp file when TRACK_ALLOCATIONS is defined.  Without
+// TRACK_ALLOCATIONS, operator new is left alone.  Zones count allocations whether or not ENABLE_PROFILING is also
+// defined to record a trace.
+//
+// Allocations are attributed to the innermost open zone.  Anything allocated outside every zone is counted under
+// "(unscoped)".  Freed memory is credited back to the zone that allocated it, even if it is freed elsewhere.
+namespace AllocTracker
+{
+	struct ScopeStats
+	{
+		const char* name {};
+		std::atomic<std::uint64_t> allocations { 0 };
+		std::atomic<std::uint64_t> bytes { 0 };
+		std::atomic<std::int64_t> liveBytes { 0 };
+		std::atomic<std::int64_t> peakLiveBytes { 0 };
+	};
+
+	// A fixed-size table, since we can't allocate memory while tracking an allocation.  Zones with the same name share
+	// an entry.
+	constexpr std::size_t maxScopes { 64 };
+	inline std::array<ScopeStats, maxScopes> scopes {};
+	inline std::size_t scopeCount { 1 }; // scope 0 is "(unscoped)"
+	inline std::mutex scopeMutex {};
+
+	// Index of the innermost open scope on this thread
+	inline thread_local std::size_t currentScope { 0 };
+
+	// Returns the table index for name, adding it if this is the first time we've seen it.
+	// If the table is full, the allocations count as unscoped.
+	inline std::size_t findScope(const char* name)
+	{
+		std::lock_guard lock { scopeMutex };
+		for (std::size_t i { 1 }; i < scopeCount; ++i)
+		{
+			if (scopes[i].name == name || std::string_view { scopes[i].name } == name)
+				return i;
+		}
+
+		if (scopeCount == maxScopes)
+			return 0;
+
+		scopes[scopeCount].name = name;
+		return scopeCount++;
+	}
+
+	inline void recordAllocation(std::size_t scope, std::size_t size)
+	{
+		ScopeStats& s { scopes[scope] };
+		s.allocations.fetch_add(1, std::memory_order_relaxed);
+		s.bytes.fetch_add(size, std::memory_order_relaxed);
+
+		std::int64_t live { s.liveBytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed) + static_cast<std::int64_t>(size) };
+		std::int64_t peak { s.peakLiveBytes.load(std::memory_order_relaxed) };
+		while (live > peak && !s.peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	inline void recordFree(std::size_t scope, std::size_t size)
+	{
+		scopes[scope].liveBytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+	}
+
+	// Makes name the current scope until destroyed (Profiler::Zone holds one of these)
+	class Scope
+	{
+	private:
+		std::size_t m_previous {};
+
+	public:
+		explicit Scope(const char* name)
+			: m_previous { currentScope }
+		{
+			currentScope = findScope(name);
+		}
+
+		~Scope()
+		{
+			currentScope = m_previous;
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	inline void printSummary(std::ostream& out)
+	{
+		std::lock_guard lock { scopeMutex };
+
+		out << std::left << std::setw(40) << "allocations by zone" << std::right
+			<< std::setw(14) << "allocations" << std::setw(16) << "bytes" << std::setw(16) << "peak live" << '\n';
+
+		for (std::size_t i { 0 }; i < scopeCount; ++i)
+		{
+			const ScopeStats& s { scopes[i] };
+			if (s.allocations.load() == 0)
+				continue;
+
+			out << std::left << std::setw(40) << (s.name ? s.name : "(unscoped)") << std::right
+				<< std::setw(14) << s.allocations.load()
+				<< std::setw(16) << s.bytes.load()
+				<< std::setw(16) << s.peakLiveBytes.load() << '\n';
+		}
+	}
+
+#ifdef TRACK_ALLOCATIONS
+	// Every block is prefixed with a header recording its size and the scope that allocated it, so operator delete
+	// can credit the right scope.  The header sits just before the pointer we return, and for over-aligned types there
+	// is padding before it, so the header also records how far back the start of the block is.
+	struct alignas(std::max_align_t) Header
+	{
+		std::size_t size {};
+		std::size_t scope {};
+		std::size_t offset {}; // from the start of the block to the pointer we returned
+	};
+
+	inline void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept
+	{
+		void* block {};
+		std::size_t offset { sizeof(Header) };
+		if (alignment <= alignof(std::max_align_t))
+			block = std::malloc(offset + size);
+		else
+		{
+			// Round the header up to a whole number of alignments, and the total up to a multiple of the alignment
+			// (as std::aligned_alloc requires)
+			offset = (offset + alignment - 1) / alignment * alignment;
+			block = std::aligned_alloc(alignment, (offset + size + alignment - 1) / alignment * alignment);
+		}
+		if (!block)
+			return nullptr;
+
+		void* ptr { static_cast<char*>(block) + offset };
+		Header* header { static_cast<Header*>(ptr) - 1 };
+		header->size = size;
+		header->scope = currentScope;
+		header->offset = offset;
+		recordAllocation(header->scope, size);
+
+		return ptr;
+	}
+
+	// Kept out of line: if GCC can see this being inlined into a delete expression, it (wrongly) warns that we're
+	// reading outside the object operator new returned, since it doesn't know about our header
+#if defined(__GNUC__) || defined(__clang__)
+	[[gnu::noinline]]
+#endif
+	inline void deallocate(void* ptr) noexcept
+	{
+		if (!ptr)
+			return;
+
+		Header* header { static_cast<Header*>(ptr) - 1 };
+		recordFree(header->scope, header->size);
+		std::free(static_cast<char*>(ptr) - header->offset);
+	}
+
+	// Prints the summary when the program exits
+	struct Reporter
+	{
+		Reporter() = default;
+		Reporter(const Reporter&) = delete;
+		Reporter& operator=(const Reporter&) = delete;
+
+		~Reporter()
+		{
+			std::cerr << '\n';
+			printSummary(std::cerr);
+		}
+	};
+
+	inline Reporter reporter {};
+#endif
+}
+
+#ifdef TRACK_ALLOCATIONS
+	void* operator new(std::size_t size)
+	{
+		if (void* ptr { AllocTracker::allocate(size) })
+			return ptr;
+		throw std::bad_alloc {};
+	}
+
+	void* operator new[](std::size_t size)
+	{
+		return operator new(size);
+	}
+
+	void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+	{
+		return AllocTracker::allocate(size);
+	}
+
+	void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+	{
+		return AllocTracker::allocate(size);
+	}
+
+	void* operator new(std::size_t size, std::align_val_t alignment)
+	{
+		if (void* ptr { AllocTracker::allocate(size, static_cast<std::size_t>(alignment)) })
+			return ptr;
+		throw std::bad_alloc {};
+	}
+
+	void* operator new[](std::size_t size, std::align_val_t alignment)
+	{
+		return operator new(size, alignment);
+	}
+
+	void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+	{
+		return AllocTracker::allocate(size, static_cast<std::size_t>(alignment));
+	}
+
+	void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+	{
+		return AllocTracker::allocate(size, static_cast<std::size_t>(alignment));
+	}
+
+	void operator delete(void* ptr) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete(void* ptr, std::size_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr, std::size_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete(void* ptr, const std::nothrow_t&) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr, const std::nothrow_t&) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete(void* ptr, std::align_val_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr, std::align_val_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocTracker::deallocate(ptr); }
+	void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocTracker::deallocate(ptr); }
+#endif
+
+#endif //ALLOCTRACKER_H
@@ -0,0 +1,260 @@
+#ifndef BASELINESTORE_H
+#define BASELINESTORE_H
+
+#include <algorithm> // for std::sort
+#include <cmath> // for std::sqrt, std::erfc, std::abs
+#include <cstddef> // for std::size_t
+#include <fstream>
+#include <cstdint> // for std::uint64_t
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <optional>
+#include <sstream> // for std::ostringstream, std::istringstream
+#include <string>
+#include <string_view>
+#include <thread> // for std::thread::hardware_concurrency
+#include <utility> // for std::move
+#include <vector>
+
+#ifdef __unix__
+	#include <unistd.h> // for gethostname
+#endif
+
+#include "Benchmark.h"
+
+// Defines GIT_REVISION, the commit being built (written by GitRevision.cmake at build time)
+#if __has_include("GitRevision.h")
+	#include "GitRevision.h"
+#endif
+
+// Stores benchmark samples between runs, and compares a new run against the stored baseline.
+//
+// The lesson notes suggest re-measuring variant 1 after measuring variant 2, to make sure the machine hasn't changed
+// underneath us.  This automates the same idea across program versions: save a baseline, change the code, run again
+// and compare.  Since two sets of timings never match exactly, we use a Mann-Whitney U test to ask whether the new
+// samples are *consistently* slower, rather than comparing two averages.  Unlike a t-test, it makes no assumption
+// about the shape of the distribution, which suits timing data with its long tail of outliers.
+//
+// The store is a plain text file with one record per line:
+//   <benchmark name> \t <git revision> \t <machine fingerprint> \t <samples separated by spaces>
+// Records are only ever appended, and a comparison uses the newest record for the same benchmark and machine.
+// Results from a different machine are never compared, since they aren't meaningful (see the notes in main.cpp).
+namespace Baseline
+{
+#ifdef GIT_REVISION
+	inline constexpr std::string_view gitRevision { GIT_REVISION };
+#else
+	inline constexpr std::string_view gitRevision { "unknown" };
+#endif
+
+	// 64-bit FNV-1a.  The fingerprint is stored in the baseline file, so it needs a hash that gives the same answer
+	// in every build, which std::hash (whose algorithm is up to each standard library) doesn't promise.
+	inline std::uint64_t fnv1a(std::string_view text)
+	{
+		std::uint64_t hash { 0xCBF29CE484222325 };
+		for (char c : text)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001B3;
+		}
+		return hash;
+	}
+
+	// A short hash of the things that make timings incomparable: which computer, which CPU, how many cores
+	inline std::string machineFingerprint()
+	{
+		std::string identity {};
+
+#ifdef __unix__
+		char host[256] {};
+		if (gethostname(host, sizeof(host) - 1) == 0)
+			identity += host;
+#endif
+
+		std::ifstream cpuinfo { "/proc/cpuinfo" };
+		std::string line {};
+		while (std::getline(cpuinfo, line))
+		{
+			if (line.starts_with("model name"))
+			{
+				identity += '|' + line;
+				break;
+			}
+		}
+
+		identity += '|' + std::to_string(std::thread::hardware_concurrency());
+
+		std::ostringstream hex {};
+		hex << std::hex << fnv1a(identity);
+		return hex.str();
+	}
+
+	struct Record
+	{
+		std::string name {};
+		std::string revision {};
+		std::string machine {};
+		std::vector<double> samples {}; // nanoseconds per iteration
+	};
+
+	class Store
+	{
+	private:
+		std::string m_path {};
+
+	public:
+		explicit Store(std::string_view path)
+			: m_path { path }
+		{
+		}
+
+		bool save(const Benchmark::Result& result, std::string_view revision, std::string_view machine) const
+		{
+			std::ofstream out { m_path, std::ios::app };
+			if (!out)
+			{
+				std::cerr << "Baseline: could not open " << m_path << " for writing\n";
+				return false;
+			}
+
+			out << result.name << '\t' << revision << '\t' << machine << '\t';
+			out << std::setprecision(6);
+			for (std::size_t i { 0 }; i < result.samples.size(); ++i)
+				out << (i ? " " : "") << result.samples[i];
+			out << '\n';
+
+			return true;
+		}
+
+		// Returns the newest record for this benchmark on this machine, if there is one
+		std::optional<Record> latest(std::string_view name, std::string_view machine) const
+		{
+			std::ifstream in { m_path };
+			std::optional<Record> found {};
+
+			std::string line {};
+			while (std::getline(in, line))
+			{
+				std::istringstream fields { line };
+				Record r {};
+				std::string samples {};
+				if (!std::getline(fields, r.name, '\t') || !std::getline(fields, r.revision, '\t')
+					|| !std::getline(fields, r.machine, '\t') || !std::getline(fields, samples))
+					continue; // skip malformed lines
+
+				if (r.name != name || r.machine != machine)
+					continue;
+
+				std::istringstream values { samples };
+				for (double v {}; values >> v;)
+					r.samples.push_back(v);
+
+				found = std::move(r);
+			}
+
+			return found;
+		}
+	};
+
+	struct Comparison
+	{
+		double baselineMedian {};
+		double currentMedian {};
+		double change {}; // relative change in the median, e.g. 0.05 for 5% slower
+		double u {};      // Mann-Whitney U statistic for the current samples
+		double p {};      // one-sided p-value for "current is slower than baseline"
+		bool regression {};
+	};
+
+	// One-sided Mann-Whitney U test of whether `current` tends to be larger (slower) than `baseline`.
+	// Uses the normal approximation (with a correction for ties), which is accurate once each side has ~10 samples.
+	inline double mannWhitneyP(const std::vector<double>& baseline, const std::vector<double>& current, double& u)
+	{
+		struct Value
+		{
+			double value {};
+			bool isCurrent {};
+		};
+
+		std::vector<Value> all {};
+		all.reserve(baseline.size() + current.size());
+		for (double v : baseline)
+			all.push_back({ v, false });
+		for (double v : current)
+			all.push_back({ v, true });
+
+		std::sort(all.begin(), all.end(), [](const Value& a, const Value& b) { return a.value < b.value; });
+
+		// Rank everything together; tied values all get the average of the ranks they span
+		double currentRankSum { 0.0 };
+		double tieCorrection { 0.0 };
+		for (std::size_t i { 0 }; i < all.size();)
+		{
+			std::size_t j { i };
+			while (j < all.size() && all[j].value == all[i].value)
+				++j;
+
+			double averageRank { (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0 };
+			for (std::size_t k { i }; k < j; ++k)
+			{
+				if (all[k].isCurrent)
+					currentRankSum += averageRank;
+			}
+
+			auto ties { static_cast<double>(j - i) };
+			tieCorrection += ties * ties * ties - ties;
+			i = j;
+		}
+
+		auto n1 { static_cast<double>(current.size()) };
+		auto n2 { static_cast<double>(baseline.size()) };
+		double n { n1 + n2 };
+
+		u = currentRankSum - n1 * (n1 + 1.0) / 2.0;
+
+		double mean { n1 * n2 / 2.0 };
+		double variance { n1 * n2 / 12.0 * ((n + 1.0) - tieCorrection / (n * (n - 1.0))) };
+		if (variance <= 0.0)
+			return 1.0; // every value is identical: no evidence of any difference
+
+		double z { (u - mean - 0.5) / std::sqrt(variance) }; // 0.5 is a continuity correction
+		return 0.5 * std::erfc(z / std::sqrt(2.0)); // P(Z >= z)
+	}
+
+	// A slowdown is flagged only if it is both statistically significant (p < alpha) and big enough to care about
+	// (the median got at least minChange slower), so a 0.1% difference measured very precisely isn't reported.
+	inline Comparison compare(const std::vector<double>& baseline, const std::vector<double>& current,
+		double alpha = 0.01, double minChange = 0.02)
+	{
+		Comparison c {};
+		if (baseline.empty() || current.empty())
+			return c;
+
+		c.baselineMedian = Benchmark::summarize(baseline).median;
+		c.currentMedian = Benchmark::summarize(current).median;
+		c.change = (c.baselineMedian > 0.0) ? (c.currentMedian - c.baselineMedian) / c.baselineMedian : 0.0;
+		c.p = mannWhitneyP(baseline, current, c.u);
+		c.regression = (c.p < alpha) && (c.change >= minChange);
+
+		return c;
+	}
+
+	inline void printComparison(std::ostream& out, std::string_view name, const Record& baseline, const Comparison& c)
+	{
+		auto flags { out.flags() };
+		auto precision { out.precision() };
+
+		out << std::left << std::setw(36) << name << std::right
+			<< std::setw(12) << Benchmark::formatTime(c.baselineMedian)
+			<< std::setw(12) << Benchmark::formatTime(c.currentMedian)
+			<< std::setw(9) << std::fixed << std::setprecision(1) << c.change * 100.0 << '%'
+			<< std::setw(11) << std::scientific << std::setprecision(2) << c.p
+			<< "  (vs " << baseline.revision << ')'
+			<< (c.regression ? "  REGRESSION" : "") << '\n';
+
+		out.flags(flags);
+		out.precision(precision);
+	}
+}
+
+#endif //BASELINESTORE_H
@@ -0,0 +1,182 @@
+#ifndef BENCHENVIRONMENT_H
+#define BENCHENVIRONMENT_H
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <fstream>
+#include <sstream> // for std::istringstream
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+	#include <sched.h> // for sched_setaffinity, sched_getcpu
+	#include <sys/mman.h> // for mlockall
+	#include <sys/resource.h> // for getrusage
+#endif
+
+// Helpers for controlling the things the lesson notes list as sources of timing variance.
+//
+// * Background load: pinToCpu() keeps the benchmark on one core, so it isn't migrated mid-sample (which throws away
+//   its warm caches), and NoiseMonitor notices when a sample was disturbed anyway, so it can be marked as noisy.
+// * Cache state: flushCaches() evicts everything we've touched, for measuring "cold" performance (like the first call
+//   after a long time doing something else).  Without it, repeated runs measure "hot" performance.
+// * Paging: lockMemory() stops the OS from paging the benchmark out, and faults in everything up front.
+//
+// Everything here is best-effort.  Functions return false when they aren't supported (e.g. not Linux, or not
+// permitted, like mlockall without enough RLIMIT_MEMLOCK), and the benchmark carries on regardless.
+namespace BenchEnvironment
+{
+	// Restricts the calling thread to run only on the given CPU
+	inline bool pinToCpu(int cpu)
+	{
+#ifdef __linux__
+		if (cpu < 0 || cpu >= CPU_SETSIZE)
+			return false;
+
+		cpu_set_t set {};
+		CPU_ZERO(&set);
+		CPU_SET(static_cast<std::size_t>(cpu), &set);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	// Which CPU the calling thread is running on right now, or -1 if unknown
+	inline int currentCpu()
+	{
+#ifdef __linux__
+		return sched_getcpu();
+#else
+		return -1;
+#endif
+	}
+
+	// Locks all current and future pages of the process into RAM
+	inline bool lockMemory()
+	{
+#ifdef __linux__
+		return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#else
+		return false;
+#endif
+	}
+
+	// Evicts the CPU caches by walking a buffer much larger than any last-level cache
+	inline void flushCaches()
+	{
+		constexpr std::size_t bufferSize { 64 * 1024 * 1024 };
+		constexpr std::size_t cacheLine { 64 };
+
+		static std::vector<unsigned char> buffer(bufferSize);
+		static unsigned char round { 0 };
+
+		++round;
+		for (std::size_t i { 0 }; i < bufferSize; i += cacheLine)
+			buffer[i] = static_cast<unsigned char>(buffer[i] + round); // a write, so the lines are really brought in
+
+		// Make sure the writes can't be optimized away
+		volatile unsigned char sink { buffer[bufferSize / 2] };
+		(void)sink;
+	}
+
+	// A snapshot of the counters NoiseMonitor compares before and after a sample
+	struct Snapshot
+	{
+		std::uint64_t stealTicks {};       // time the hypervisor ran someone else on our CPU
+		long involuntarySwitches {};       // times the OS preempted this thread
+		long frequencyKHz {};              // current frequency of the CPU we're on (0 if unknown)
+		int cpu { -1 };
+	};
+
+	// The steal time of one CPU, from its own line of /proc/stat.  (The first line adds up every CPU, so on a VM it
+	// would count time stolen from the other cores too, which doesn't disturb us.)
+	inline std::uint64_t readStealTicks(int cpu)
+	{
+		if (cpu < 0)
+			return 0;
+
+		std::ifstream stat { "/proc/stat" };
+		const std::string label { "cpu" + std::to_string(cpu) };
+		std::string line {};
+		while (std::getline(stat, line))
+		{
+			// cpuN user nice system idle iowait irq softirq steal ...
+			std::istringstream fields { line };
+			std::string name {};
+			fields >> name;
+			if (name != label)
+				continue;
+
+			std::uint64_t values[8] {};
+			for (auto& v : values)
+				fields >> v;
+			return values[7];
+		}
+
+		return 0;
+	}
+
+	inline long readFrequencyKHz(int cpu)
+	{
+		if (cpu < 0)
+			return 0;
+
+		std::ifstream freq { "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_cur_freq" };
+		long khz { 0 };
+		freq >> khz;
+		return khz;
+	}
+
+	inline Snapshot takeSnapshot()
+	{
+		Snapshot s {};
+#ifdef __linux__
+		rusage usage {};
+		if (getrusage(RUSAGE_THREAD, &usage) == 0)
+			s.involuntarySwitches = usage.ru_nivcsw;
+
+		s.cpu = currentCpu();
+		s.stealTicks = readStealTicks(s.cpu);
+		s.frequencyKHz = readFrequencyKHz(s.cpu);
+#endif
+		return s;
+	}
+
+	// Wrap a sample in begin() / end().  end() returns true if something happened during the sample that probably
+	// disturbed it: we were preempted, the hypervisor stole time from our CPU, we migrated to another CPU, or the CPU
+	// changed frequency by more than 5%.
+	class NoiseMonitor
+	{
+	private:
+		Snapshot m_before {};
+
+	public:
+		void begin() { m_before = takeSnapshot(); }
+
+		bool end() const
+		{
+			Snapshot after { takeSnapshot() };
+
+			if (after.involuntarySwitches != m_before.involuntarySwitches)
+				return true;
+			if (after.stealTicks != m_before.stealTicks)
+				return true;
+			if (after.cpu != m_before.cpu)
+				return true;
+			if (m_before.frequencyKHz > 0 && after.frequencyKHz > 0)
+			{
+				long difference { after.frequencyKHz - m_before.frequencyKHz };
+				if (difference < 0)
+					difference = -difference;
+				if (difference * 20 > m_before.frequencyKHz)
+					return true;
+			}
+
+			return false;
+		}
+	};
+}
+
+#endif //BENCHENVIRONMENT_H
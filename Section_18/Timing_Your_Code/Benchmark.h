@@ -0,0 +1,390 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm> // for std::sort, std::min, std::max
+#include <atomic> // for std::atomic_signal_fence
+#include <cmath> // for std::abs, std::floor
+#include <cstddef> // for std::size_t
+#include <iomanip> // for std::setw, std::setprecision
+#include <iostream>
+#include <iterator> // for std::size
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BenchEnvironment.h"
+#include "Timer.h"
+
+// This header-only Benchmark namespace builds a statistical micro-benchmark runner on top of Timer.
+// Instead of a single elapsed() reading, each benchmark is:
+// * warmed up (so caches, branch predictors and lazy initialization don't pollute the first sample)
+// * calibrated (the repetition count is grown until one sample takes long enough to swamp clock overhead)
+// * sampled repeatedly, and summarized with robust statistics (min, median, MAD, p99) rather than a mean,
+//   so the occasional outlier caused by background load doesn't skew the result.
+namespace Benchmark
+{
+	// Stops the optimizer from discarding a value we computed but never otherwise use.
+	// The empty asm statement claims to read value (and all of memory), so the computation has to happen.
+#if defined(__GNUC__) || defined(__clang__)
+	template <typename T>
+	inline void doNotOptimize(const T& value)
+	{
+		__asm__ __volatile__("" : : "m"(value) : "memory");
+	}
+
+	template <typename T>
+	inline void doNotOptimize(T& value)
+	{
+		__asm__ __volatile__("" : "+m"(value) : : "memory");
+	}
+
+	// Forces all pending writes to memory to actually happen before this point
+	inline void clobberMemory()
+	{
+		__asm__ __volatile__("" : : : "memory");
+	}
+#else
+	// Portable (but slightly more expensive) fallback: route the value's address through a volatile pointer
+	template <typename T>
+	inline void doNotOptimize(const T& value)
+	{
+		static const volatile void* sink{};
+		sink = &value;
+	}
+
+	inline void clobberMemory()
+	{
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+#endif
+
+	enum class CacheMode
+	{
+		hot,  // caches are left warm from the previous iteration, as when calling something in a loop
+		cold, // caches are flushed before every sample (so each sample is a single iteration)
+	};
+
+	struct Options
+	{
+		int warmupRuns { 3 };           // untimed runs before calibration
+		int samples { 30 };             // number of timed samples to collect
+		double minSampleTime { 0.01 };  // each sample should take at least this long (in seconds)
+		std::size_t maxIterations { 1'000'000'000 };
+		CacheMode cacheMode { CacheMode::hot };
+		bool detectNoise { true };      // mark samples disturbed by preemption, steal time, migration or frequency changes
+	};
+
+	// All times are in nanoseconds per iteration
+	struct Stats
+	{
+		double min {};
+		double max {};
+		double mean {};
+		double median {};
+		double mad {}; // median absolute deviation from the median
+		double p99 {};
+	};
+
+	struct Result
+	{
+		std::string name {};
+		std::size_t iterations {}; // iterations per sample
+		std::vector<double> samples {}; // nanoseconds per iteration, in the order they were taken
+		std::vector<bool> noisy {}; // noisy[i] is true if samples[i] was probably disturbed
+		std::size_t noisyCount {};
+		Stats stats {}; // computed from the clean samples only, as long as at least half of them were clean
+	};
+
+	// Returns the p-th percentile (0.0 to 1.0) of an already sorted vector, linearly interpolating between ranks
+	inline double percentile(const std::vector<double>& sorted, double p)
+	{
+		if (sorted.empty())
+			return 0.0;
+
+		double rank { p * static_cast<double>(sorted.size() - 1) };
+		auto lower { static_cast<std::size_t>(std::floor(rank)) };
+		std::size_t upper { std::min(lower + 1, sorted.size() - 1) };
+		double fraction { rank - static_cast<double>(lower) };
+
+		return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+	}
+
+	inline Stats summarize(std::vector<double> samples) // by value, since we need a sorted copy anyway
+	{
+		Stats stats {};
+		if (samples.empty())
+			return stats;
+
+		std::sort(samples.begin(), samples.end());
+
+		double sum { 0.0 };
+		for (double s : samples)
+			sum += s;
+
+		stats.min = samples.front();
+		stats.max = samples.back();
+		stats.mean = sum / static_cast<double>(samples.size());
+		stats.median = percentile(samples, 0.5);
+		stats.p99 = percentile(samples, 0.99);
+
+		std::vector<double> deviations {};
+		deviations.reserve(samples.size());
+		for (double s : samples)
+			deviations.push_back(std::abs(s - stats.median));
+		std::sort(deviations.begin(), deviations.end());
+		stats.mad = percentile(deviations, 0.5);
+
+		return stats;
+	}
+
+	// Times `iterations` back-to-back calls of fn, returning the total elapsed seconds
+	template <typename F>
+	double timeBatch(F& fn, std::size_t iterations)
+	{
+		Timer t {};
+		for (std::size_t i { 0 }; i < iterations; ++i)
+			fn();
+		clobberMemory();
+		return t.elapsed();
+	}
+
+	// Formats a duration given in nanoseconds using a sensible unit
+	inline std::string formatTime(double ns)
+	{
+		static constexpr std::string_view units[] { "ns", "us", "ms", "s" };
+
+		std::size_t unit { 0 };
+		while (ns >= 1000.0 && unit < std::size(units) - 1)
+		{
+			ns /= 1000.0;
+			++unit;
+		}
+
+		std::string number { std::to_string(ns) };
+		number.resize(std::min(number.size(), ns >= 100.0 ? std::size_t { 5 } : std::size_t { 4 })); // keep 3-4 significant digits
+		if (!number.empty() && number.back() == '.')
+			number.pop_back();
+
+		return number + ' ' + std::string { units[unit] };
+	}
+
+	// The shortest time a Timer can measure: the smallest non-zero reading we get by starting a Timer and reading it
+	// straight away, which covers both the clock's tick and the cost of reading it.  Measured once.
+	inline double timerResolution()
+	{
+		static const double s_resolution { [] {
+			double smallest { 1.0 };
+			for (int i { 0 }; i < 1000; ++i)
+			{
+				Timer t {};
+				double seconds { t.elapsed() };
+				while (seconds <= 0.0)
+					seconds = t.elapsed();
+				smallest = std::min(smallest, seconds);
+			}
+			return smallest;
+		}() };
+
+		return s_resolution;
+	}
+
+	// In CacheMode::cold, each sample is a single call, so a call has to take at least this many times the timer's
+	// resolution for the sample to measure the call rather than the clock (to within about 1%)
+	constexpr double minColdResolutions { 100.0 };
+
+	// Grows the repetition count until a single batch takes at least options.minSampleTime
+	template <typename F>
+	std::size_t calibrate(F& fn, const Options& options)
+	{
+		std::size_t iterations { 1 };
+		while (iterations < options.maxIterations)
+		{
+			double seconds { timeBatch(fn, iterations) };
+			if (seconds >= options.minSampleTime)
+				break;
+
+			// Jump straight towards the target (with some headroom), but never grow by more than 10x at once,
+			// since a very short batch is dominated by clock overhead and makes a poor prediction
+			double factor { (seconds > 0.0) ? (options.minSampleTime * 1.2 / seconds) : 10.0 };
+			factor = std::clamp(factor, 2.0, 10.0);
+			iterations = std::min(options.maxIterations, static_cast<std::size_t>(static_cast<double>(iterations) * factor));
+		}
+
+		return iterations;
+	}
+
+	// Adds one sample, and updates the statistics once all of the samples are in
+	inline void addSample(Result& result, double nanosecondsPerIteration, bool noisy)
+	{
+		result.samples.push_back(nanosecondsPerIteration);
+		result.noisy.push_back(noisy);
+		if (noisy)
+			++result.noisyCount;
+	}
+
+	inline void finish(Result& result)
+	{
+		if (result.noisyCount * 2 > result.samples.size())
+		{
+			// Too few clean samples to be worth anything on their own, so just use everything
+			result.stats = summarize(result.samples);
+			return;
+		}
+
+		std::vector<double> clean {};
+		for (std::size_t i { 0 }; i < result.samples.size(); ++i)
+		{
+			if (!result.noisy[i])
+				clean.push_back(result.samples[i]);
+		}
+		result.stats = summarize(clean);
+	}
+
+	// Times a batch (calling setup and flushing the caches first, as needed), checking whether it was disturbed
+	template <typename Setup, typename F>
+	void takeSample(Result& result, Setup& setup, F& fn, const Options& options)
+	{
+		setup();
+		if (options.cacheMode == CacheMode::cold)
+			BenchEnvironment::flushCaches();
+		clobberMemory();
+
+		BenchEnvironment::NoiseMonitor monitor {};
+		if (options.detectNoise)
+			monitor.begin();
+
+		double seconds { timeBatch(fn, result.iterations) };
+
+		bool noisy { options.detectNoise && monitor.end() };
+		addSample(result, seconds * 1e9 / static_cast<double>(result.iterations), noisy);
+	}
+
+	// Benchmarks fn, calling setup (untimed) before every sample.
+	// Use a setup when fn consumes its input, e.g. sorting an array that must be re-shuffled before each sort.
+	// Since setup has to run between iterations, each sample is then a single iteration and no calibration is done,
+	// so fn should take considerably longer than a Timer reading.  The same applies in CacheMode::cold.
+	template <typename Setup, typename F>
+	Result run(std::string_view name, Setup&& setup, F&& fn, const Options& options = {})
+	{
+		for (int i { 0 }; i < options.warmupRuns; ++i)
+		{
+			setup();
+			fn();
+		}
+
+		Result result { std::string { name }, 1, {}, {}, 0, {} };
+		result.samples.reserve(static_cast<std::size_t>(options.samples));
+
+		for (int i { 0 }; i < options.samples; ++i)
+			takeSample(result, setup, fn, options);
+
+		finish(result);
+		return result;
+	}
+
+	// Benchmarks fn, which should be cheap to call repeatedly on the same state (e.g. a search or a lookup)
+	// In CacheMode::cold, fn is only timed one call at a time if a call takes long enough for that to be meaningful
+	// (see minColdResolutions).  Otherwise a warning is printed to std::cerr and fn is measured hot instead.
+	template <typename F>
+	Result run(std::string_view name, F&& fn, const Options& options = {})
+	{
+		auto noSetup { []() {} };
+
+		for (int i { 0 }; i < options.warmupRuns; ++i)
+			fn();
+
+		std::size_t iterations { calibrate(fn, options) };
+
+		if (options.cacheMode == CacheMode::cold)
+		{
+			double perCall { timeBatch(fn, iterations) / static_cast<double>(iterations) };
+			if (perCall >= timerResolution() * minColdResolutions)
+				return run(name, noSetup, fn, options);
+
+			std::cerr << "Benchmark: " << name << " takes about " << formatTime(perCall * 1e9) << " per call, too close to the"
+				<< " timer's resolution (" << formatTime(timerResolution() * 1e9) << ") to time cold, so it is measured hot\n";
+		}
+
+		Result result { std::string { name }, iterations, {}, {}, 0, {} };
+		result.samples.reserve(static_cast<std::size_t>(options.samples));
+
+		for (int i { 0 }; i < options.samples; ++i)
+			takeSample(result, noSetup, fn, options);
+
+		finish(result);
+		return result;
+	}
+
+	inline void printTextHeader(std::ostream& out)
+	{
+		out << std::left << std::setw(32) << "benchmark"
+			<< std::right << std::setw(12) << "iterations"
+			<< std::setw(12) << "min"
+			<< std::setw(12) << "median"
+			<< std::setw(12) << "MAD"
+			<< std::setw(12) << "p99"
+			<< std::setw(8) << "noisy" << '\n';
+	}
+
+	inline void printText(std::ostream& out, const Result& r)
+	{
+		out << std::left << std::setw(32) << r.name
+			<< std::right << std::setw(12) << r.iterations
+			<< std::setw(12) << formatTime(r.stats.min)
+			<< std::setw(12) << formatTime(r.stats.median)
+			<< std::setw(12) << formatTime(r.stats.mad)
+			<< std::setw(12) << formatTime(r.stats.p99)
+			<< std::setw(8) << r.noisyCount << '\n';
+	}
+
+	inline void printText(std::ostream& out, const std::vector<Result>& results)
+	{
+		printTextHeader(out);
+		for (const auto& r : results)
+			printText(out, r);
+	}
+
+	inline std::string jsonEscape(std::string_view s)
+	{
+		std::string escaped {};
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	inline void printJson(std::ostream& out, const std::vector<Result>& results)
+	{
+		auto flags { out.flags() };
+		auto precision { out.precision() };
+		out << std::fixed << std::setprecision(3);
+
+		out << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [";
+		bool comma { false };
+		for (const auto& r : results)
+		{
+			out << (comma ? ",\n" : "\n");
+			comma = true;
+
+			out << "    { \"name\": \"" << jsonEscape(r.name) << "\""
+				<< ", \"iterations\": " << r.iterations
+				<< ", \"samples\": " << r.samples.size()
+				<< ", \"noisy\": " << r.noisyCount
+				<< ", \"min\": " << r.stats.min
+				<< ", \"median\": " << r.stats.median
+				<< ", \"mad\": " << r.stats.mad
+				<< ", \"p99\": " << r.stats.p99
+				<< ", \"mean\": " << r.stats.mean
+				<< ", \"max\": " << r.stats.max << " }";
+		}
+		out << "\n  ]\n}\n";
+
+		out.flags(flags);
+		out.precision(precision);
+	}
+}
+
+#endif //BENCHMARK_H
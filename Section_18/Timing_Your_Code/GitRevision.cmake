@@ -0,0 +1,23 @@
+# Writes GitRevision.h into OUTPUT_DIR, defining GIT_REVISION as the short hash of the commit checked out in
+# SOURCE_DIR (see BaselineStore.h).  Run with cmake -P by the GitRevision target in CMakeLists.txt, on every build.
+execute_process(COMMAND git rev-parse --short HEAD
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE GIT_REVISION
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET)
+
+if (GIT_REVISION)
+    set(CONTENTS "#define GIT_REVISION \"${GIT_REVISION}\"\n")
+else()
+    set(CONTENTS "// Not built from a git checkout, so BaselineStore.h uses \"unknown\"\n")
+endif()
+
+# Leave the file alone if nothing changed, so the build doesn't recompile everything that includes it
+set(HEADER ${OUTPUT_DIR}/GitRevision.h)
+set(OLD_CONTENTS "")
+if (EXISTS ${HEADER})
+    file(READ ${HEADER} OLD_CONTENTS)
+endif()
+if (NOT EXISTS ${HEADER} OR NOT OLD_CONTENTS STREQUAL CONTENTS)
+    file(WRITE ${HEADER} "${CONTENTS}")
+endif()
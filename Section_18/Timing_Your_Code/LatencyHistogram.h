@@ -0,0 +1,172 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <algorithm> // for std::min, std::max
+#include <bit> // for std::bit_width
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "Timer.h"
+
+// A log-linear ("HDR") histogram of latencies, in nanoseconds.
+//
+// Timer::elapsed() tells us the total time for a run, but for anything that handles many requests (hands, guesses,
+// lookups) what we usually care about is the distribution: the median, and how bad the slowest 1% or 0.1% are.
+// Keeping every sample to sort later costs memory proportional to the number of samples; this histogram has a fixed
+// size instead.
+//
+// Values below 2^SubBucketBits are counted exactly.  Above that, each power-of-two range [2^e, 2^(e+1)) is split into
+// 2^SubBucketBits equal-width buckets, so every value is stored with a relative error of at most 2^-SubBucketBits
+// (under 1% with the default of 7 bits) no matter how large it is.  Finding the bucket for a value is a couple of
+// shifts, so record() takes constant time.
+//
+// A histogram is not thread-safe.  Give each thread its own, and merge() them at the end.
+template <int SubBucketBits = 7>
+class BasicLatencyHistogram
+{
+private:
+	static constexpr std::uint64_t subBucketCount { std::uint64_t { 1 } << SubBucketBits };
+	static constexpr std::size_t bucketCount { static_cast<std::size_t>((64 - SubBucketBits + 1) * subBucketCount) };
+
+	std::vector<std::uint64_t> m_counts { std::vector<std::uint64_t>(bucketCount) };
+	std::uint64_t m_total { 0 };
+	std::uint64_t m_min { std::numeric_limits<std::uint64_t>::max() };
+	std::uint64_t m_max { 0 };
+	double m_sum { 0.0 };
+
+	static std::size_t indexOf(std::uint64_t value)
+	{
+		if (value < subBucketCount)
+			return static_cast<std::size_t>(value);
+
+		// Keep the top SubBucketBits+1 bits of the value.  shift counts the bits we throw away.
+		auto shift { static_cast<std::uint64_t>(std::bit_width(value)) - SubBucketBits - 1 };
+		return static_cast<std::size_t>((shift << SubBucketBits) + (value >> shift));
+	}
+
+	// Smallest value that lands in bucket index
+	static std::uint64_t lowestValueAt(std::size_t index)
+	{
+		std::uint64_t i { index };
+		if (i < 2 * subBucketCount)
+			return i;
+
+		std::uint64_t shift { (i >> SubBucketBits) - 1 };
+		return (i - (shift << SubBucketBits)) << shift;
+	}
+
+	// Largest value that lands in bucket index
+	static std::uint64_t highestValueAt(std::size_t index)
+	{
+		std::uint64_t i { index };
+		if (i < 2 * subBucketCount)
+			return i;
+
+		std::uint64_t shift { (i >> SubBucketBits) - 1 };
+		return lowestValueAt(index) + (std::uint64_t { 1 } << shift) - 1;
+	}
+
+public:
+	void record(std::uint64_t nanoseconds)
+	{
+		++m_counts[indexOf(nanoseconds)];
+		++m_total;
+		m_min = std::min(m_min, nanoseconds);
+		m_max = std::max(m_max, nanoseconds);
+		m_sum += static_cast<double>(nanoseconds);
+	}
+
+	// Convenience overload for a Timer::elapsed() reading (in seconds)
+	void recordSeconds(double seconds)
+	{
+		record(seconds <= 0.0 ? 0 : static_cast<std::uint64_t>(seconds * 1e9));
+	}
+
+	// Records how long it has been since timer was started (or reset)
+	template <typename Clock>
+	void recordElapsed(const BasicTimer<Clock>& timer)
+	{
+		recordSeconds(timer.elapsed());
+	}
+
+	void merge(const BasicLatencyHistogram& other)
+	{
+		for (std::size_t i { 0 }; i < bucketCount; ++i)
+			m_counts[i] += other.m_counts[i];
+
+		m_total += other.m_total;
+		m_min = std::min(m_min, other.m_min);
+		m_max = std::max(m_max, other.m_max);
+		m_sum += other.m_sum;
+	}
+
+	void reset()
+	{
+		std::fill(m_counts.begin(), m_counts.end(), 0);
+		m_total = 0;
+		m_min = std::numeric_limits<std::uint64_t>::max();
+		m_max = 0;
+		m_sum = 0.0;
+	}
+
+	std::uint64_t count() const { return m_total; }
+	std::uint64_t min() const { return m_total ? m_min : 0; }
+	std::uint64_t max() const { return m_max; }
+	double mean() const { return m_total ? m_sum / static_cast<double>(m_total) : 0.0; }
+
+	// Returns the value at percentile p (0.0 to 100.0), i.e. the value that p% of recorded values are at or below.
+	// The result is the top of the bucket containing that value, so it never understates the latency.
+	std::uint64_t valueAtPercentile(double p) const
+	{
+		if (m_total == 0)
+			return 0;
+
+		double clamped { std::clamp(p, 0.0, 100.0) };
+		auto target { static_cast<std::uint64_t>(clamped / 100.0 * static_cast<double>(m_total) + 0.5) };
+		target = std::clamp<std::uint64_t>(target, 1, m_total);
+
+		std::uint64_t seen { 0 };
+		for (std::size_t i { 0 }; i < bucketCount; ++i)
+		{
+			seen += m_counts[i];
+			if (seen >= target)
+				return std::min(highestValueAt(i), m_max);
+		}
+
+		return m_max;
+	}
+
+	void printPercentiles(std::ostream& out) const
+	{
+		static constexpr double percentiles[] { 50.0, 90.0, 99.0, 99.9, 99.99 };
+
+		out << "count " << count() << ", min " << min() << " ns, mean " << static_cast<std::uint64_t>(mean())
+			<< " ns, max " << max() << " ns\n";
+		for (double p : percentiles)
+			out << "    p" << std::left << std::setw(8) << p << std::right << std::setw(14) << valueAtPercentile(p) << " ns\n";
+	}
+
+	// Prints one line per non-empty bucket: the bucket's upper bound, and the fraction of values at or below it
+	void printCdf(std::ostream& out) const
+	{
+		out << "value_ns,count,cumulative_fraction\n";
+
+		std::uint64_t seen { 0 };
+		for (std::size_t i { 0 }; i < bucketCount; ++i)
+		{
+			if (m_counts[i] == 0)
+				continue;
+
+			seen += m_counts[i];
+			out << highestValueAt(i) << ',' << m_counts[i] << ',' << static_cast<double>(seen) / static_cast<double>(m_total) << '\n';
+		}
+	}
+};
+
+using LatencyHistogram = BasicLatencyHistogram<>;
+
+#endif //LATENCYHISTOGRAM_H
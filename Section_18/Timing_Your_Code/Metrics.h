@@ -0,0 +1,292 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cassert>
+#include <bit> // for std::bit_width
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t, std::uint64_t, std::int64_t
+#include <cstdlib> // for std::getenv
+#include <iostream>
+#include <mutex>
+#include <new> // for placement new
+#include <string>
+#include <string_view>
+#include <utility> // for std::move
+
+#ifdef __linux__
+	#include <cerrno>
+	#include <fcntl.h> // for open
+	#include <signal.h> // for kill
+	#include <sys/mman.h> // for mmap
+	#include <unistd.h> // for ftruncate, close, getpid, pread, unlink
+#endif
+
+// Live metrics that another process can watch while a long simulation runs.
+//
+// Counters, gauges and histograms live in a memory-mapped file in /dev/shm, so updating one is just a relaxed atomic
+// add to memory: no locks, no system calls and no I/O on the hot path.  MetricsReader maps the same file and prints
+// the current values and rates once a second.
+//
+// This is the same idea as accumulate() in the chapter 7 summary, which keeps its running total in a static local
+// variable so it survives between calls.  Here the static local holds a handle to a slot in shared memory, so the
+// registration (which takes a lock) only happens on the first call:
+//
+//   static Metrics::Counter hands { Metrics::counter("blackjack.hands") };
+//   hands.add();
+//
+// The file is /dev/shm/<LEARNCPP_METRICS> if that environment variable is set (and is left behind when the program
+// exits, so the final values can still be read), otherwise /dev/shm/learncpp.<pid> (removed at exit).  A file left
+// behind by an earlier run is replaced, but not one whose program is still running.  If the file can't be created,
+// the metrics are kept in ordinary memory instead, so the program works the same either way.
+namespace Metrics
+{
+	constexpr std::uint32_t magic { 0x4D50434C }; // "LCPM"
+	constexpr std::uint32_t version { 1 };
+	constexpr std::size_t maxMetrics { 64 };
+	constexpr std::size_t nameLength { 48 };
+	constexpr std::size_t histogramBuckets { 64 }; // bucket i holds values in [2^(i-1), 2^i)
+
+	// The reader is a different process, so the atomics must work without a lock hidden inside this process
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+	static_assert(std::atomic<std::int64_t>::is_always_lock_free);
+
+	enum class Kind : std::uint32_t
+	{
+		unused,
+		counter,
+		gauge,
+		histogram,
+	};
+
+	// One metric.  Each slot gets its own cache lines, so threads updating different metrics don't slow each other down.
+	struct alignas(64) Slot
+	{
+		std::atomic<Kind> kind { Kind::unused }; // set last, so the reader never sees a half-written name
+		char name[nameLength] {};
+		std::atomic<std::int64_t> value { 0 }; // counter total, gauge value, or histogram count
+		std::atomic<std::uint64_t> sum { 0 };  // histogram only
+		std::atomic<std::uint64_t> buckets[histogramBuckets] {};
+	};
+
+	struct Segment
+	{
+		std::uint32_t magic {};
+		std::uint32_t version {};
+		std::int64_t pid {};
+		std::atomic<std::uint32_t> slotCount { 0 };
+		Slot slots[maxMetrics] {};
+	};
+
+	class Registry
+	{
+	private:
+		Segment* m_segment {};
+		Segment m_private {}; // used if the shared file can't be created
+		Slot m_overflow {};   // shared by every metric registered after the table is full (not exported)
+		std::string m_path {};
+		bool m_removeAtExit { false };
+		std::mutex m_mutex {};
+
+#ifdef __linux__
+		// The pid of the program that wrote the metrics file at path, or -1 if it isn't a complete metrics file
+		static std::int64_t owner(const std::string& path)
+		{
+			int fd { open(path.c_str(), O_RDONLY) };
+			if (fd < 0)
+				return -1;
+
+			// The first three members of Segment (reading them, rather than mapping the file, is safe even if it's short)
+			struct
+			{
+				std::uint32_t magic;
+				std::uint32_t version;
+				std::int64_t pid;
+			} header {};
+			bool complete { pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+				&& header.magic == magic && header.version == version };
+			close(fd);
+
+			return complete ? header.pid : -1;
+		}
+#endif
+
+		void map()
+		{
+#ifdef __linux__
+			std::string name {};
+			if (const char* env { std::getenv("LEARNCPP_METRICS") }; env && *env)
+				name = env;
+			else
+			{
+				name = "learncpp." + std::to_string(getpid());
+				m_removeAtExit = true;
+			}
+
+			std::string path { "/dev/shm/" + name };
+			int fd { open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644) };
+			if (fd < 0 && errno == EEXIST)
+			{
+				// Another program exporting to the same name would be cut off from its readers, so only a file whose
+				// program has exited is replaced
+				std::int64_t pid { owner(path) };
+				if (pid < 0)
+				{
+					std::cerr << "Metrics: " << path << " already exists and isn't a metrics file, so metrics won't be"
+						<< " exported (remove it, or set LEARNCPP_METRICS to another name)\n";
+					return;
+				}
+				// (A file with our own pid was left by an earlier program that had it)
+				if (pid != getpid() && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM))
+				{
+					std::cerr << "Metrics: " << path << " is in use by process " << pid << ", so metrics won't be"
+						<< " exported (set LEARNCPP_METRICS to another name)\n";
+					return;
+				}
+
+				// A MetricsReader may still have the old file mapped.  Truncating it would make the reader crash with
+				// SIGBUS, so we remove it and create a new one: the reader keeps its mapping of the old file, and sees
+				// the new one when it next opens the name.
+				unlink(path.c_str());
+				fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+			}
+			if (fd < 0)
+				return;
+
+			void* address { MAP_FAILED };
+			if (ftruncate(fd, sizeof(Segment)) == 0)
+				address = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd); // the mapping stays valid after the file descriptor is closed
+
+			if (address == MAP_FAILED)
+			{
+				unlink(path.c_str());
+				return;
+			}
+
+			m_segment = new (address) Segment {};
+			m_segment->pid = getpid();
+			m_segment->version = version;
+			std::atomic_thread_fence(std::memory_order_release);
+			m_segment->magic = magic; // written last, so the reader knows the rest is ready
+			m_path = std::move(path);
+#endif
+		}
+
+	public:
+		Registry()
+		{
+			map();
+			if (!m_segment)
+				m_segment = &m_private;
+		}
+
+		~Registry()
+		{
+#ifdef __linux__
+			if (m_segment != &m_private)
+			{
+				munmap(m_segment, sizeof(Segment));
+				if (m_removeAtExit)
+					unlink(m_path.c_str());
+			}
+#endif
+		}
+
+		Registry(const Registry&) = delete;
+		Registry& operator=(const Registry&) = delete;
+
+		// Where the metrics are being exported, or an empty string if they aren't
+		const std::string& path() const { return m_path; }
+
+		// Returns the slot for name, adding it if this is the first time we've seen it.  A name can only be used for
+		// one kind of metric: asking for it as another kind (e.g. counter("x"), then histogram("x")) is a bug, and
+		// gets the unexported overflow slot, so the two don't corrupt each other.
+		Slot& find(std::string_view name, Kind kind)
+		{
+			std::lock_guard lock { m_mutex };
+
+			std::uint32_t count { m_segment->slotCount.load(std::memory_order_relaxed) };
+			for (std::uint32_t i { 0 }; i < count; ++i)
+			{
+				Slot& slot { m_segment->slots[i] };
+				if (std::string_view { slot.name } == name.substr(0, nameLength - 1))
+				{
+					bool sameKind { slot.kind.load(std::memory_order_relaxed) == kind };
+					assert(sameKind && "Metrics: a name was registered as two different kinds of metric");
+					return sameKind ? slot : m_overflow;
+				}
+			}
+
+			if (count == maxMetrics)
+				return m_overflow;
+
+			Slot& slot { m_segment->slots[count] };
+			name.substr(0, nameLength - 1).copy(slot.name, nameLength - 1);
+			slot.kind.store(kind, std::memory_order_release);
+			m_segment->slotCount.store(count + 1, std::memory_order_release);
+			return slot;
+		}
+	};
+
+	inline Registry& registry()
+	{
+		static Registry s_registry {};
+		return s_registry;
+	}
+
+	// A total that only goes up, e.g. hands played.  The reader shows it as a rate.
+	class Counter
+	{
+	private:
+		Slot* m_slot {};
+
+	public:
+		explicit Counter(Slot& slot) : m_slot { &slot } {}
+
+		void add(std::int64_t amount = 1) { m_slot->value.fetch_add(amount, std::memory_order_relaxed); }
+	};
+
+	// A value that can go up and down, e.g. cards left in the deck
+	class Gauge
+	{
+	private:
+		Slot* m_slot {};
+
+	public:
+		explicit Gauge(Slot& slot) : m_slot { &slot } {}
+
+		void set(std::int64_t value) { m_slot->value.store(value, std::memory_order_relaxed); }
+		void add(std::int64_t amount) { m_slot->value.fetch_add(amount, std::memory_order_relaxed); }
+	};
+
+	// A distribution of non-negative values (typically nanoseconds), in power-of-two buckets.  This is much coarser
+	// than LatencyHistogram, but it is cheap enough to update from several threads at once.
+	class Histogram
+	{
+	private:
+		Slot* m_slot {};
+
+	public:
+		explicit Histogram(Slot& slot) : m_slot { &slot } {}
+
+		void record(std::uint64_t value)
+		{
+			std::size_t bucket { static_cast<std::size_t>(std::bit_width(value)) };
+			if (bucket >= histogramBuckets)
+				bucket = histogramBuckets - 1;
+
+			m_slot->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+			m_slot->sum.fetch_add(value, std::memory_order_relaxed);
+			m_slot->value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void recordSeconds(double seconds) { record(static_cast<std::uint64_t>(seconds * 1e9)); }
+	};
+
+	inline Counter counter(std::string_view name) { return Counter { registry().find(name, Kind::counter) }; }
+	inline Gauge gauge(std::string_view name) { return Gauge { registry().find(name, Kind::gauge) }; }
+	inline Histogram histogram(std::string_view name) { return Histogram { registry().find(name, Kind::histogram) }; }
+}
+
+#endif //METRICS_H
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::int64_t, std::uint64_t
+#include <cstdlib> // for std::atof
+#include <filesystem>
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread> // for std::this_thread::sleep_for
+#include <vector>
+
+#include <fcntl.h> // for open
+#include <signal.h> // for kill
+#include <sys/mman.h> // for mmap
+#include <unistd.h> // for close
+
+#include "Metrics.h"
+
+// Watches the metrics a running program exports through Metrics.h, e.g.
+//   LEARNCPP_METRICS=blackjack ./Blackjack --simulate 100000000 &
+//   ./MetricsReader blackjack
+// Counters are shown as a total and a rate (per second, over the last interval), gauges as their current value, and
+// histograms as a count, mean and approximate percentiles.
+
+// Maps the segment read-only.  Reading only ever loads from the atomics, so the writer is never slowed down.
+const Metrics::Segment* openSegment(const std::string& path)
+{
+	int fd { open(path.c_str(), O_RDONLY) };
+	if (fd < 0)
+		return nullptr;
+
+	void* address { mmap(nullptr, sizeof(Metrics::Segment), PROT_READ, MAP_SHARED, fd, 0) };
+	close(fd);
+	if (address == MAP_FAILED)
+		return nullptr;
+
+	const auto* segment { static_cast<const Metrics::Segment*>(address) };
+	if (segment->magic != Metrics::magic || segment->version != Metrics::version)
+	{
+		munmap(address, sizeof(Metrics::Segment));
+		return nullptr;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	return segment;
+}
+
+// An upper bound for the p-th percentile (0-100), from the power-of-two buckets
+std::uint64_t histogramPercentile(const Metrics::Slot& slot, std::uint64_t count, double p)
+{
+	auto target { static_cast<std::uint64_t>(static_cast<double>(count) * p / 100.0) };
+	std::uint64_t seen { 0 };
+	for (std::size_t i { 0 }; i < Metrics::histogramBuckets; ++i)
+	{
+		seen += slot.buckets[i].load(std::memory_order_relaxed);
+		if (seen > target)
+			return (i == 0) ? 0 : (std::uint64_t { 1 } << i) - 1;
+	}
+	return ~std::uint64_t { 0 };
+}
+
+void printSlot(const Metrics::Slot& slot, std::int64_t previous, double interval)
+{
+	std::int64_t value { slot.value.load(std::memory_order_relaxed) };
+	std::cout << std::left << std::setw(32) << slot.name << std::right;
+
+	switch (slot.kind.load(std::memory_order_acquire))
+	{
+	case Metrics::Kind::counter:
+		std::cout << std::setw(16) << value << std::setw(16) << static_cast<double>(value - previous) / interval << "/s\n";
+		break;
+
+	case Metrics::Kind::gauge:
+		std::cout << std::setw(16) << value << '\n';
+		break;
+
+	case Metrics::Kind::histogram:
+	{
+		auto count { static_cast<std::uint64_t>(value) };
+		std::cout << std::setw(16) << count << std::setw(16) << static_cast<double>(value - previous) / interval << "/s";
+		if (count > 0)
+		{
+			double mean { static_cast<double>(slot.sum.load(std::memory_order_relaxed)) / static_cast<double>(count) };
+			std::cout << "  mean " << mean
+				<< "  p50 <" << histogramPercentile(slot, count, 50.0)
+				<< "  p99 <" << histogramPercentile(slot, count, 99.0);
+		}
+		std::cout << '\n';
+		break;
+	}
+
+	default:
+		std::cout << '\n';
+		break;
+	}
+}
+
+// Usage: MetricsReader                    list the programs currently exporting metrics
+//        MetricsReader <name> [seconds]   print <name>'s metrics every [seconds] (default 1) until it exits
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::error_code error {};
+		for (const auto& entry : std::filesystem::directory_iterator { "/dev/shm", error })
+		{
+			std::string path { entry.path().string() };
+			if (const Metrics::Segment* segment { openSegment(path) })
+			{
+				std::cout << entry.path().filename().string() << " (pid " << segment->pid << ")\n";
+				munmap(const_cast<Metrics::Segment*>(segment), sizeof(Metrics::Segment));
+			}
+		}
+		return 0;
+	}
+
+	std::string_view name { argv[1] };
+	std::string path { name.starts_with('/') ? std::string { name } : "/dev/shm/" + std::string { name } };
+	double interval { (argc >= 3) ? std::atof(argv[2]) : 1.0 };
+	if (interval <= 0.0)
+		interval = 1.0;
+
+	const Metrics::Segment* segment { openSegment(path) };
+	if (!segment)
+	{
+		std::cerr << "Could not open metrics at " << path << '\n';
+		return 1;
+	}
+
+	std::vector<std::int64_t> previous(Metrics::maxMetrics);
+	while (true)
+	{
+		std::uint32_t count { segment->slotCount.load(std::memory_order_acquire) };
+		for (std::uint32_t i { 0 }; i < count; ++i)
+			previous[i] = segment->slots[i].value.load(std::memory_order_relaxed);
+
+		std::this_thread::sleep_for(std::chrono::duration<double> { interval });
+
+		// Checked before printing, so the last values shown are the final ones
+		bool running { kill(static_cast<pid_t>(segment->pid), 0) == 0 };
+
+		count = segment->slotCount.load(std::memory_order_acquire);
+		for (std::uint32_t i { 0 }; i < count; ++i)
+			printSlot(segment->slots[i], previous[i], interval);
+		std::cout << '\n';
+
+		if (!running)
+			break;
+	}
+
+	return 0;
+}
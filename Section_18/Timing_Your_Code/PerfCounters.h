@@ -0,0 +1,210 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <cstdint> // for std::uint64_t
+#include <cstring> // for std::memset
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <utility> // for std::forward
+
+#include "Timer.h"
+
+#ifdef __linux__
+	#include <linux/perf_event.h> // for perf_event_attr and the PERF_* constants
+	#include <sys/ioctl.h> // for ioctl
+	#include <sys/syscall.h> // for SYS_perf_event_open
+	#include <unistd.h> // for syscall, read, close
+#endif
+
+// Wall time tells us how long something took, but not why.  On Linux, the CPU's hardware performance counters can
+// tell us how many instructions were executed, how many cycles they took, and how often we missed the caches or
+// mispredicted a branch.  PerfCounters opens these counters (via perf_event_open) around a measured region and
+// returns them alongside Timer::elapsed().
+//
+// Counters are opened for the calling thread only, and only count user-space work.  Any counter the kernel refuses
+// to open (no PMU in a VM, perf_event_paranoid too strict, unsupported event) is reported as unavailable rather than
+// failing the whole measurement.  On non-Linux platforms every counter is unavailable.
+namespace Perf
+{
+	enum Counter
+	{
+		cycles,
+		instructions,
+		l1dMisses,
+		llcMisses,
+		branchMisses,
+		pageFaults,
+
+		max_counters
+	};
+
+	constexpr std::array<std::string_view, max_counters> counterNames { "cycles", "instructions", "L1d misses", "LLC misses", "branch misses", "page faults" };
+
+	struct Reading
+	{
+		double elapsed {}; // seconds
+		std::array<std::optional<std::uint64_t>, max_counters> counts {};
+
+		// Instructions per cycle, or nothing if either counter is unavailable
+		std::optional<double> ipc() const
+		{
+			if (!counts[cycles] || !counts[instructions] || *counts[cycles] == 0)
+				return std::nullopt;
+			return static_cast<double>(*counts[instructions]) / static_cast<double>(*counts[cycles]);
+		}
+
+		// Counter value divided by some unit of work (e.g. elements sorted)
+		std::optional<double> per(Counter counter, double units) const
+		{
+			if (!counts[counter] || units <= 0.0)
+				return std::nullopt;
+			return static_cast<double>(*counts[counter]) / units;
+		}
+	};
+
+	class PerfCounters
+	{
+	private:
+		std::array<int, max_counters> m_fds {};
+		Timer m_timer {};
+
+#ifdef __linux__
+		static int open(std::uint32_t type, std::uint64_t config)
+		{
+			perf_event_attr attr {};
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			// If the kernel has to multiplex counters, these let us scale the count up to the full run
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		}
+
+		static constexpr std::uint64_t cacheConfig(std::uint64_t cache)
+		{
+			return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		}
+#endif
+
+	public:
+		PerfCounters()
+		{
+			m_fds.fill(-1);
+#ifdef __linux__
+			m_fds[cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			m_fds[instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			m_fds[l1dMisses] = open(PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D));
+			m_fds[llcMisses] = open(PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_LL));
+			m_fds[branchMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+			m_fds[pageFaults] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+		}
+
+		~PerfCounters()
+		{
+#ifdef __linux__
+			for (int fd : m_fds)
+			{
+				if (fd >= 0)
+					close(fd);
+			}
+#endif
+		}
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		bool available(Counter counter) const { return m_fds[counter] >= 0; }
+
+		bool anyAvailable() const
+		{
+			for (int fd : m_fds)
+			{
+				if (fd >= 0)
+					return true;
+			}
+			return false;
+		}
+
+		void start()
+		{
+#ifdef __linux__
+			for (int fd : m_fds)
+			{
+				if (fd >= 0)
+				{
+					ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+					ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+				}
+			}
+#endif
+			m_timer.reset();
+		}
+
+		Reading stop()
+		{
+			Reading reading {};
+			reading.elapsed = m_timer.elapsed();
+
+#ifdef __linux__
+			for (int fd : m_fds)
+			{
+				if (fd >= 0)
+					ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+
+			for (std::size_t i { 0 }; i < m_fds.size(); ++i)
+			{
+				if (m_fds[i] < 0)
+					continue;
+
+				std::uint64_t values[3] {}; // value, time enabled, time running
+				if (read(m_fds[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0)
+					continue;
+
+				// Scale up if the counter was only scheduled for part of the time it was enabled
+				double scale { static_cast<double>(values[1]) / static_cast<double>(values[2]) };
+				reading.counts[i] = static_cast<std::uint64_t>(static_cast<double>(values[0]) * scale);
+			}
+#endif
+			return reading;
+		}
+	};
+
+	// Runs fn once with the counters enabled
+	template <typename F>
+	Reading measure(PerfCounters& counters, F&& fn)
+	{
+		counters.start();
+		std::forward<F>(fn)();
+		return counters.stop();
+	}
+
+	// Prints the elapsed time, IPC, and every counter both in total and per unit of work
+	inline void print(std::ostream& out, std::string_view name, const Reading& r, double units, std::string_view unitName)
+	{
+		out << name << ": " << r.elapsed << " seconds";
+		if (auto ipc { r.ipc() })
+			out << ", IPC " << *ipc;
+		out << '\n';
+
+		for (std::size_t i { 0 }; i < max_counters; ++i)
+		{
+			out << "    " << std::left << std::setw(16) << counterNames[i] << std::right;
+			if (auto perUnit { r.per(static_cast<Counter>(i), units) })
+				out << std::setw(16) << *r.counts[i] << std::setw(16) << *perUnit << " per " << unitName << '\n';
+			else
+				out << std::setw(16) << "n/a" << '\n';
+		}
+	}
+}
+
+#endif //PERFCOUNTERS_H
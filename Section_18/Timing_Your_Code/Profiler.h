@@ -0,0 +1,226 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef> // for std::size_t
+#include <fstream>
+#include <iomanip> // for std::setprecision
+#include <iostream>
+#include <memory> // for std::unique_ptr
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AllocTracker.h"
+#include "Timer.h"
+
+// This header-only Profiler namespace records hierarchical profiling zones and writes them out as Chrome trace-event
+// JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// A zone is an RAII object: it records a begin event when constructed and an end event when destroyed, so nested
+// scopes show up as nested bars in the trace viewer. Each thread appends its events to its own fixed-size buffer,
+// so recording an event never takes a lock. The only lock is taken once per thread, the first time that thread
+// records anything, to register its buffer so writeChromeTrace() can find it later.
+//
+// Zones also count the heap allocations made while they are open, when TRACK_ALLOCATIONS is defined (see
+// AllocTracker.h).
+//
+// Use the PROFILE_SCOPE / PROFILE_FUNCTION macros rather than Zone directly. They compile to nothing unless
+// ENABLE_PROFILING or TRACK_ALLOCATIONS is defined, so instrumentation can stay in the code at no cost.
+namespace Profiler
+{
+#ifdef ENABLE_PROFILING
+	inline constexpr bool tracing { true };
+#else
+	inline constexpr bool tracing { false }; // only counting allocations, so zones don't record trace events
+#endif
+
+	// All timestamps are measured from this Timer, which is started when the program starts
+	inline const Timer epoch {};
+
+	// Microseconds since program start (the unit the trace-event format expects)
+	inline double now()
+	{
+		return epoch.elapsed() * 1e6;
+	}
+
+	struct Event
+	{
+		const char* name {}; // must point at a string literal (or something else that outlives the program)
+		double timestamp {}; // microseconds
+		char phase {}; // 'B' for begin, 'E' for end
+	};
+
+	class ThreadBuffer
+	{
+	public:
+		static constexpr std::size_t capacity { 1 << 16 };
+
+	private:
+		std::array<Event, capacity> m_events {};
+		std::atomic<std::size_t> m_count { 0 }; // published with release, so a flushing thread sees whole events
+		std::size_t m_depth { 0 }; // number of currently open zones
+		std::size_t m_dropped { 0 };
+		int m_threadId {};
+
+	public:
+		explicit ThreadBuffer(int threadId)
+			: m_threadId { threadId }
+		{
+		}
+
+		// Returns false (and records nothing) if the buffer is too full.
+		// We always keep room for the end events of every open zone, so the trace never has an unmatched begin.
+		bool begin(const char* name)
+		{
+			std::size_t count { m_count.load(std::memory_order_relaxed) };
+			if (count + m_depth + 2 > capacity)
+			{
+				++m_dropped;
+				return false;
+			}
+
+			m_events[count] = Event { name, now(), 'B' };
+			m_count.store(count + 1, std::memory_order_release);
+			++m_depth;
+			return true;
+		}
+
+		void end(const char* name)
+		{
+			std::size_t count { m_count.load(std::memory_order_relaxed) };
+			m_events[count] = Event { name, now(), 'E' };
+			m_count.store(count + 1, std::memory_order_release);
+			--m_depth;
+		}
+
+		std::size_t size() const { return m_count.load(std::memory_order_acquire); }
+		const Event& operator[](std::size_t index) const { return m_events[index]; }
+		std::size_t dropped() const { return m_dropped; }
+		int threadId() const { return m_threadId; }
+	};
+
+	// Owns every thread's buffer.  Buffers are never freed before the program ends, so events recorded by threads
+	// that have already exited still make it into the trace.
+	class Registry
+	{
+	private:
+		std::mutex m_mutex {};
+		std::vector<std::unique_ptr<ThreadBuffer>> m_buffers {};
+
+	public:
+		ThreadBuffer& registerThread()
+		{
+			std::lock_guard lock { m_mutex };
+			m_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(m_buffers.size()) + 1));
+			return *m_buffers.back();
+		}
+
+		// Writes every event recorded so far.  Threads may keep recording while this runs.
+		void writeChromeTrace(std::ostream& out)
+		{
+			std::lock_guard lock { m_mutex };
+
+			auto flags { out.flags() };
+			auto precision { out.precision() };
+			out << std::fixed << std::setprecision(3);
+
+			out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+			bool comma { false };
+			for (const auto& buffer : m_buffers)
+			{
+				std::size_t count { buffer->size() };
+				for (std::size_t i { 0 }; i < count; ++i)
+				{
+					const Event& e { (*buffer)[i] };
+					out << (comma ? ",\n" : "\n");
+					comma = true;
+					out << "{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase << "\",\"ts\":" << e.timestamp
+						<< ",\"pid\":1,\"tid\":" << buffer->threadId() << '}';
+				}
+
+				if (buffer->dropped() > 0)
+					std::cerr << "Profiler: thread " << buffer->threadId() << " dropped " << buffer->dropped() << " zones (buffer full)\n";
+			}
+			out << "\n]}\n";
+
+			out.flags(flags);
+			out.precision(precision);
+		}
+	};
+
+	inline Registry registry {};
+
+	inline ThreadBuffer& threadBuffer()
+	{
+		thread_local ThreadBuffer& buffer { registry.registerThread() };
+		return buffer;
+	}
+
+	class Zone
+	{
+	private:
+		const char* m_name {};
+		bool m_recorded {};
+#ifdef TRACK_ALLOCATIONS
+		AllocTracker::Scope m_allocations;
+#endif
+
+	public:
+		explicit Zone(const char* name)
+			: m_name { name }
+			, m_recorded { tracing && threadBuffer().begin(name) }
+#ifdef TRACK_ALLOCATIONS
+			, m_allocations { name }
+#endif
+		{
+		}
+
+		~Zone()
+		{
+			if (m_recorded)
+				threadBuffer().end(m_name);
+		}
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+	};
+
+	inline void writeChromeTrace(std::ostream& out)
+	{
+		registry.writeChromeTrace(out);
+	}
+
+	inline bool writeChromeTrace(std::string_view path)
+	{
+		std::ofstream out { std::string { path } };
+		if (!out)
+		{
+			std::cerr << "Profiler: could not open " << path << " for writing\n";
+			return false;
+		}
+
+		writeChromeTrace(out);
+		return true;
+	}
+}
+
+#if defined(ENABLE_PROFILING) || defined(TRACK_ALLOCATIONS)
+	#define PROFILE_CONCAT_IMPL(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+	#define PROFILE_SCOPE(name) const Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__) { name }
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+#endif
+
+#ifdef ENABLE_PROFILING
+	#define PROFILE_WRITE_TRACE(path) Profiler::writeChromeTrace(std::string_view { path })
+#else
+	#define PROFILE_WRITE_TRACE(path)
+#endif
+
+#endif //PROFILER_H
@@ -0,0 +1,215 @@
+#ifndef SAMPLINGPROFILER_H
+#define SAMPLINGPROFILER_H
+
+#include <atomic>
+#include <cstddef> // for std::size_t
+#include <cstdlib> // for std::getenv, std::strtol, std::free
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory> // for std::unique_ptr
+#include <string>
+#include <utility> // for std::move
+
+#ifdef __linux__
+	#include <cerrno> // for errno
+	#include <csignal> // for sigaction, SIGPROF
+	#include <cxxabi.h> // for abi::__cxa_demangle
+	#include <dlfcn.h> // for dladdr
+	#include <execinfo.h> // for backtrace
+	#include <sys/time.h> // for setitimer
+#endif
+
+// A built-in sampling profiler.  Instead of timing particular scopes (like Profiler.h does), it interrupts the
+// program many times a second and records where it was.  Functions that show up in many samples are where the time
+// goes.  This needs no instrumentation in the code being profiled, so it is handy for long simulations.
+//
+// To use it, #include this header in the file containing main(), and set an environment variable when running:
+//   LEARNCPP_PROFILE=blackjack.folded ./Blackjack --simulate 1000000
+//   LEARNCPP_PROFILE_HZ=4999 (optional, samples per second of CPU time, default 999)
+// When the program exits, the samples are written in "folded stack" format (one line per unique call stack, with
+// frames separated by semicolons and followed by a count), which flamegraph.pl, speedscope.app and inferno accept.
+// If LEARNCPP_PROFILE isn't set, the profiler does nothing.
+//
+// How it works: setitimer(ITIMER_PROF) delivers SIGPROF after every interval of CPU time the process uses.  The
+// signal handler can't safely allocate or lock, so it only copies the return addresses on the stack into the next
+// slot of a preallocated ring buffer.  All the expensive work (turning addresses into function names, and counting
+// identical stacks) happens once, at exit.  Link with -rdynamic (ENABLE_EXPORTS in CMake) so that functions in the
+// executable itself can be named.
+namespace SamplingProfiler
+{
+	constexpr std::size_t maxDepth { 64 };
+	constexpr std::size_t capacity { 1 << 15 }; // once full, the oldest samples are overwritten
+
+	struct Sample
+	{
+		void* frames[maxDepth] {};
+		int depth {};
+	};
+
+#ifdef __linux__
+	inline Sample* g_samples {};
+	inline std::atomic<std::size_t> g_sampleCount { 0 };
+
+	// Frames belonging to the signal handler and the kernel's signal trampoline, which we don't want in the output
+	constexpr int skippedFrames { 2 };
+
+	inline void onSignal(int)
+	{
+		int savedErrno { errno };
+
+		std::size_t index { g_sampleCount.fetch_add(1, std::memory_order_relaxed) % capacity };
+		Sample& sample { g_samples[index] };
+		sample.depth = backtrace(sample.frames, static_cast<int>(maxDepth));
+
+		errno = savedErrno;
+	}
+
+	inline std::string symbolize(void* address)
+	{
+		Dl_info info {};
+		if (dladdr(address, &info) == 0 || !info.dli_sname)
+			return "[unknown]";
+
+		int status {};
+		char* demangled { abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status) };
+		std::string name { (status == 0 && demangled) ? demangled : info.dli_sname };
+		std::free(demangled);
+
+		// Function parameters make the flame graph very wide; the name alone is usually enough
+		if (auto paren { name.find('(') }; paren != std::string::npos && paren > 0)
+			name.resize(paren);
+
+		return name;
+	}
+
+	class Session
+	{
+	private:
+		std::unique_ptr<Sample[]> m_samples {};
+		std::string m_path {};
+		bool m_running { false };
+
+		void writeFolded()
+		{
+			std::size_t total { g_sampleCount.load() };
+			std::size_t count { total < capacity ? total : capacity };
+
+			std::map<void*, std::string> names {}; // symbolize each address only once
+			std::map<std::string, std::size_t> stacks {};
+
+			for (std::size_t i { 0 }; i < count; ++i)
+			{
+				const Sample& sample { m_samples[i] };
+
+				// Outermost frame first, separated by semicolons
+				std::string stack {};
+				for (int f { sample.depth - 1 }; f >= skippedFrames; --f)
+				{
+					// Each frame (other than the interrupted one) is a return address, which points just past the call.
+					// Back up a byte so we name the function making the call, not whatever follows it.
+					void* address { sample.frames[f] };
+					if (f != skippedFrames)
+						address = static_cast<char*>(address) - 1;
+
+					auto found { names.find(address) };
+					if (found == names.end())
+						found = names.emplace(address, symbolize(address)).first;
+
+					if (!stack.empty())
+						stack += ';';
+					stack += found->second;
+				}
+
+				if (!stack.empty())
+					++stacks[stack];
+			}
+
+			std::ofstream out { m_path };
+			if (!out)
+			{
+				std::cerr << "SamplingProfiler: could not open " << m_path << " for writing\n";
+				return;
+			}
+
+			for (const auto& [stack, hits] : stacks)
+				out << stack << ' ' << hits << '\n';
+
+			std::cerr << "SamplingProfiler: wrote " << count << " samples";
+			if (total > capacity)
+				std::cerr << " (the oldest " << total - capacity << " were overwritten)";
+			std::cerr << " to " << m_path << '\n';
+		}
+
+	public:
+		Session()
+		{
+			const char* path { std::getenv("LEARNCPP_PROFILE") };
+			if (path && *path)
+				start(path);
+		}
+
+		~Session()
+		{
+			stop();
+		}
+
+		Session(const Session&) = delete;
+		Session& operator=(const Session&) = delete;
+
+		void start(std::string path)
+		{
+			if (m_running)
+				return;
+
+			long hz { 999 }; // an odd rate, so we don't sample in lockstep with anything periodic in the program
+			if (const char* rate { std::getenv("LEARNCPP_PROFILE_HZ") })
+				hz = std::strtol(rate, nullptr, 10);
+			if (hz <= 0 || hz > 100000)
+				hz = 999;
+
+			m_path = std::move(path);
+			m_samples = std::make_unique<Sample[]>(capacity);
+			g_samples = m_samples.get();
+			g_sampleCount = 0;
+
+			// The first call to backtrace() loads libgcc, which allocates.  Get that out of the way now, rather than
+			// doing it inside the signal handler.
+			void* warmup[1] {};
+			backtrace(warmup, 1);
+
+			struct sigaction action {};
+			action.sa_handler = onSignal;
+			action.sa_flags = SA_RESTART;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGPROF, &action, nullptr);
+
+			itimerval timer {};
+			timer.it_interval.tv_sec = 0;
+			timer.it_interval.tv_usec = static_cast<suseconds_t>(1'000'000 / hz);
+			timer.it_value = timer.it_interval;
+			setitimer(ITIMER_PROF, &timer, nullptr);
+
+			m_running = true;
+		}
+
+		void stop()
+		{
+			if (!m_running)
+				return;
+
+			itimerval timer {};
+			setitimer(ITIMER_PROF, &timer, nullptr);
+			signal(SIGPROF, SIG_IGN); // a signal that was already pending can still arrive after the timer is off
+
+			m_running = false;
+			writeFolded();
+		}
+	};
+
+	// Starts automatically (if LEARNCPP_PROFILE is set) before main() runs, and writes its output after main() returns
+	inline Session session {};
+#endif
+}
+
+#endif //SAMPLINGPROFILER_H
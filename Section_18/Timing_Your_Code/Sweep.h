@@ -0,0 +1,180 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <algorithm> // for std::sort, std::max
+#include <barrier>
+#include <cassert>
+#include <cstddef> // for std::size_t
+#include <functional> // for std::function
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility> // for std::move
+#include <vector>
+
+#include "Benchmark.h"
+
+// Runs registered benchmarks across a range of input sizes and thread counts, and prints the results as CSV.
+//
+// A single input size only tells us about one point on the curve.  Sweeping the size from something that fits in the
+// L1 cache to something that only fits in main memory shows the "cache cliffs" where ns/element jumps, and sweeping
+// the thread count shows whether throughput scales with cores or is limited by shared caches and memory bandwidth.
+//
+// Each registered benchmark provides a factory: given an input size, it builds that thread's private input and
+// returns the operation to time, plus how many elements each call to the operation processes.  Every thread gets its
+// own input, so threads never share data; what they do share is the machine.
+namespace Sweep
+{
+	struct Workload
+	{
+		std::function<void()> operation {};
+		std::size_t elementsPerCall {}; // must be at least 1, since results are reported per element
+		std::size_t bytesPerElement { sizeof(int) };
+	};
+
+	using Factory = std::function<Workload(std::size_t elements)>;
+
+	struct Registration
+	{
+		std::string name {};
+		Factory factory {};
+		std::size_t maxElements {}; // skip larger sizes (e.g. for O(n^2) algorithms)
+	};
+
+	inline std::vector<Registration>& registry()
+	{
+		static std::vector<Registration> s_registry {};
+		return s_registry;
+	}
+
+	inline void add(std::string_view name, Factory factory, std::size_t maxElements = static_cast<std::size_t>(-1))
+	{
+		registry().push_back({ std::string { name }, std::move(factory), maxElements });
+	}
+
+	struct Options
+	{
+		std::vector<std::size_t> sizes {};   // number of elements
+		std::vector<unsigned int> threads {};
+		double minTime { 0.05 };             // each thread runs for at least this long (in seconds) per measurement
+	};
+
+	// 1K elements up to maxElements, growing by 4x each step.  With 4-byte elements this goes from 4 KB (fits in any
+	// L1 cache) to 16 MB by default (bigger than most last-level caches).
+	inline std::vector<std::size_t> defaultSizes(std::size_t maxElements = 4 * 1024 * 1024)
+	{
+		std::vector<std::size_t> sizes {};
+		for (std::size_t n { 1024 }; n <= maxElements; n *= 4)
+			sizes.push_back(n);
+		return sizes;
+	}
+
+	// 1, 2, 4, ... up to the number of hardware threads (which is always included)
+	inline std::vector<unsigned int> defaultThreadCounts()
+	{
+		unsigned int hardware { std::max(1u, std::thread::hardware_concurrency()) };
+
+		std::vector<unsigned int> counts {};
+		for (unsigned int t { 1 }; t < hardware; t *= 2)
+			counts.push_back(t);
+		counts.push_back(hardware);
+		return counts;
+	}
+
+	struct Point
+	{
+		std::size_t bytes {};           // size of each thread's input
+		std::size_t iterations {};      // calls per thread
+		double nsPerElement {};         // median across threads
+		double elementsPerSecond {};    // all threads combined
+	};
+
+	inline Point measure(const Registration& r, std::size_t elements, unsigned int threadCount, double minTime)
+	{
+		// Calibrate on a single thread: how many calls take about minTime?
+		std::size_t iterations {};
+		{
+			Workload w { r.factory(elements) };
+			assert(w.elementsPerCall > 0 && "Sweep: a Workload must process at least one element per call");
+
+			Benchmark::Options calibration {};
+			calibration.minSampleTime = minTime;
+			w.operation(); // warm up
+			iterations = Benchmark::calibrate(w.operation, calibration);
+		}
+
+		std::vector<double> seconds(threadCount);
+		std::barrier start { static_cast<std::ptrdiff_t>(threadCount) };
+		std::size_t elementsPerCall {};
+		std::size_t bytesPerElement {};
+
+		auto body { [&](unsigned int index) {
+			Workload w { r.factory(elements) }; // each thread builds its own input
+			if (index == 0)
+			{
+				elementsPerCall = w.elementsPerCall;
+				bytesPerElement = w.bytesPerElement;
+			}
+			w.operation(); // warm up this thread's caches
+
+			start.arrive_and_wait(); // so all threads run at the same time
+			seconds[index] = Benchmark::timeBatch(w.operation, iterations);
+		} };
+
+		std::vector<std::thread> workers {};
+		for (unsigned int i { 1 }; i < threadCount; ++i)
+			workers.emplace_back(body, i);
+		body(0);
+		for (auto& worker : workers)
+			worker.join();
+
+		std::vector<double> perElement {};
+		double slowest { 0.0 };
+		for (double s : seconds)
+		{
+			perElement.push_back(s * 1e9 / static_cast<double>(iterations * elementsPerCall));
+			slowest = std::max(slowest, s);
+		}
+
+		Point p {};
+		p.bytes = elements * bytesPerElement;
+		p.iterations = iterations;
+		p.nsPerElement = Benchmark::summarize(perElement).median;
+		// Throughput over the time the slowest thread took (setup isn't included, unlike wall-clock time)
+		p.elementsPerSecond = static_cast<double>(iterations * elementsPerCall) * static_cast<double>(threadCount) / slowest;
+		return p;
+	}
+
+	inline void printCsvHeader(std::ostream& out)
+	{
+		out << "benchmark,elements,bytes,threads,iterations,ns_per_element,elements_per_second\n";
+	}
+
+	// Runs every registered benchmark whose name starts with filter (all of them if filter is empty)
+	inline void run(std::ostream& out, const Options& options, std::string_view filter = {})
+	{
+		printCsvHeader(out);
+
+		for (const auto& r : registry())
+		{
+			if (!r.name.starts_with(filter))
+				continue;
+
+			for (std::size_t elements : options.sizes)
+			{
+				if (elements > r.maxElements)
+					continue;
+
+				for (unsigned int threads : options.threads)
+				{
+					Point p { measure(r, elements, threads, options.minTime) };
+					out << r.name << ',' << elements << ',' << p.bytes << ',' << threads << ','
+						<< p.iterations << ',' << p.nsPerElement << ',' << p.elementsPerSecond << '\n';
+				}
+			}
+		}
+	}
+}
+
+#endif //SWEEP_H
@@ -3,11 +3,13 @@
 
 #include <chrono> // for std::chrono functions
 
-class Timer
+// The clock is a template parameter so a cheaper clock (e.g. TscClock from TscClock.h) can be swapped in.
+// Any type that meets the standard Clock requirements (like the std::chrono clocks) will work.
+template <typename Clock = std::chrono::steady_clock>
+class BasicTimer
 {
 private:
 	// Type aliases to make accessing nested type easier
-	using Clock = std::chrono::steady_clock;
 	using Second = std::chrono::duration<double, std::ratio<1> >;
 
 	std::chrono::time_point<Clock> m_beg { Clock::now() };
@@ -24,6 +26,7 @@ public:
 	}
 };
 
-
+// Existing code keeps using Timer, which is backed by std::chrono::steady_clock
+using Timer = BasicTimer<>;
 
 #endif //TIMER_H
@@ -2,27 +2,43 @@
 #include <array>
 #include <chrono> // for std::chrono functions
 #include <cstddef> // for std::size_t
+#include <cstdlib> // for std::atoi, std::atoll
+#include <memory> // for std::make_shared
+#include <iomanip> // for std::setw
 #include <iostream>
-#include <numeric> // for std::iota
+#include <numeric> // for std::iota, std::midpoint
+#include <random> // for std::mt19937
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 
-#include "Timer.h"
+#include "BaselineStore.h"
+#include "BenchEnvironment.h"
+#include "Benchmark.h"
+#include "IntArray.h"
+#include "PerfCounters.h"
+#include "Sweep.h"
+#include "TscClock.h"
 
 const int g_arrayElements { 10000 };
-const int g_arrayElements2 { 10000 };
 
-void sortArray(std::array<int, g_arrayElements>& array)
+// Takes a std::span so the same sort can be run on any size of input (a std::array converts to a std::span implicitly)
+void sortArray(std::span<int> array)
 {
+	if (array.empty())
+		return;
 
 	// Step through each element of the array
 	// (except the last one, which will already be sorted by the time we get there)
-	for (std::size_t startIndex{ 0 }; startIndex < (g_arrayElements - 1); ++startIndex)
+	for (std::size_t startIndex{ 0 }; startIndex < (array.size() - 1); ++startIndex)
 	{
 		// smallestIndex is the index of the smallest element we’ve encountered this iteration
 		// Start by assuming the smallest element is the first element of this iteration
 		std::size_t smallestIndex{ startIndex };
 
 		// Then look for a smaller element in the rest of the array
-		for (std::size_t currentIndex{ startIndex + 1 }; currentIndex < g_arrayElements; ++currentIndex)
+		for (std::size_t currentIndex{ startIndex + 1 }; currentIndex < array.size(); ++currentIndex)
 		{
 			// If we've found an element that is smaller than our previously found smallest
 			if (array[currentIndex] < array[smallestIndex])
@@ -38,32 +54,391 @@ void sortArray(std::array<int, g_arrayElements>& array)
 	}
 }
 
-int main()
+// Iterative binary search from the chapter 20 summary quiz.
+// Returns the index of the target element if the target is found, -1 otherwise
+int binarySearch(const int* array, int target, int min, int max)
 {
-	std::array<int, g_arrayElements> array;
-	std::iota(array.rbegin(), array.rend(), 1); // fill the array with values 10000 to 1
+	while (min <= max)
+	{
+		int midpoint{ std::midpoint(min, max) };
+
+		if (array[midpoint] > target)
+			max = midpoint - 1;
+		else if (array[midpoint] < target)
+			min = midpoint + 1;
+		else
+			return midpoint;
+	}
+
+	return -1;
+}
+
+std::vector<Benchmark::Result> runSortBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	// Rather than timing each sort once, we re-fill the array (untimed) before every sample and take many samples
+	std::array<int, g_arrayElements> array {};
+	auto refill { [&array]() { std::iota(array.rbegin(), array.rend(), 1); } }; // fill the array with values 10000 to 1
+
+	Benchmark::Options slow { options };
+	slow.warmupRuns = 1;
+	slow.samples = 10; // the selection sort takes tens of milliseconds per run
+	results.push_back(Benchmark::run("sort/selection", refill, [&array]() {
+		sortArray(array);
+		Benchmark::doNotOptimize(array);
+	}, slow));
+
+	results.push_back(Benchmark::run("sort/std::ranges::sort", refill, [&array]() {
+		std::ranges::sort(array); // Since C++20
+		Benchmark::doNotOptimize(array);
+	}, options));
+
+	return results;
+}
+
+std::vector<Benchmark::Result> runSearchBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	static std::array<int, g_arrayElements> array {};
+	std::iota(array.begin(), array.end(), 1); // sorted values 1 to 10000
+
+	// Cycle through a spread of targets so we aren't just measuring one well-predicted search path
+	int target { 0 };
+	results.push_back(Benchmark::run("search/binarySearch", [&target]() {
+		target = (target + 7919) % (g_arrayElements + 1);
+		int index { binarySearch(array.data(), target, 0, g_arrayElements - 1) };
+		Benchmark::doNotOptimize(index);
+	}, options));
+
+	results.push_back(Benchmark::run("search/std::lower_bound", [&target]() {
+		target = (target + 7919) % (g_arrayElements + 1);
+		auto found { std::lower_bound(array.begin(), array.end(), target) };
+		Benchmark::doNotOptimize(found);
+	}, options));
+
+	return results;
+}
+
+std::vector<Benchmark::Result> runContainerBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	constexpr int count { 1000 };
+
+	results.push_back(Benchmark::run("container/IntArray::insertAtEnd", []() {
+		IntArray array {};
+		for (int i { 0 }; i < count; ++i)
+			array.insertAtEnd(i);
+		Benchmark::doNotOptimize(array);
+	}, options));
+
+	results.push_back(Benchmark::run("container/std::vector::push_back", []() {
+		std::vector<int> v {};
+		for (int i { 0 }; i < count; ++i)
+			v.push_back(i);
+		Benchmark::doNotOptimize(v);
+	}, options));
+
+	return results;
+}
+
+// How much does reading each clock cost?  This bounds how small a region we can sensibly time with it.
+std::vector<Benchmark::Result> runClockBenchmarks(const Benchmark::Options& options)
+{
+	std::vector<Benchmark::Result> results {};
+
+	results.push_back(Benchmark::run("clock/steady_clock::now", []() {
+		auto t { std::chrono::steady_clock::now() };
+		Benchmark::doNotOptimize(t);
+	}, options));
+
+	results.push_back(Benchmark::run("clock/TscClock::now (plain)", []() {
+		auto t { BasicTscClock<TscRead::plain>::now() };
+		Benchmark::doNotOptimize(t);
+	}, options));
+
+	results.push_back(Benchmark::run("clock/TscClock::now (lfence)", []() {
+		auto t { BasicTscClock<TscRead::lfence>::now() };
+		Benchmark::doNotOptimize(t);
+	}, options));
+
+	results.push_back(Benchmark::run("clock/TscClock::now (rdtscp)", []() {
+		auto t { TscClock::now() };
+		Benchmark::doNotOptimize(t);
+	}, options));
+
+	return results;
+}
+
+// Runs each sort once with the hardware performance counters enabled, to show *why* one is faster than the other
+void runPerfCounters()
+{
+	Perf::PerfCounters counters {};
+	if (!counters.anyAvailable())
+	{
+		std::cout << "No performance counters available (not Linux, or perf_event_paranoid is too strict)\n";
+		return;
+	}
+
+	std::array<int, g_arrayElements> array {};
+
+	std::iota(array.rbegin(), array.rend(), 1);
+	Perf::Reading selection { Perf::measure(counters, [&array]() { sortArray(array); }) };
+	Benchmark::doNotOptimize(array);
+	Perf::print(std::cout, "sortArray", selection, g_arrayElements, "element");
+
+	std::iota(array.rbegin(), array.rend(), 1);
+	Perf::Reading ranges { Perf::measure(counters, [&array]() { std::ranges::sort(array); }) };
+	Benchmark::doNotOptimize(array);
+	Perf::print(std::cout, "std::ranges::sort", ranges, g_arrayElements, "element");
+}
+
+// Compares each result against the newest stored baseline from this machine, printing the comparison to out.  Returns
+// the number of regressions.
+int compareWithBaseline(std::ostream& out, const Baseline::Store& store, const std::vector<Benchmark::Result>& results)
+{
+	const std::string machine { Baseline::machineFingerprint() };
+	int regressions { 0 };
+
+	out << std::left << std::setw(36) << "benchmark" << std::right << std::setw(12) << "baseline"
+		<< std::setw(12) << "current" << std::setw(10) << "change" << std::setw(11) << "p" << '\n';
 
-	Timer t;
+	for (const auto& r : results)
+	{
+		auto baseline { store.latest(r.name, machine) };
+		if (!baseline)
+		{
+			out << std::left << std::setw(36) << r.name << std::right << "  (no baseline on this machine)\n";
+			continue;
+		}
+
+		Baseline::Comparison c { Baseline::compare(baseline->samples, r.samples) };
+		Baseline::printComparison(out, r.name, *baseline, c);
+		if (c.regression)
+			++regressions;
+	}
+
+	return regressions;
+}
 
-	sortArray(array);
+// Random (but the same every run, see the notes below) values for sorting and searching
+std::vector<int> makeRandomInput(std::size_t elements)
+{
+	std::mt19937 mt { 42 };
+	std::vector<int> v(elements);
+	for (auto& e : v)
+		e = static_cast<int>(mt() >> 1);
+	return v;
+}
 
-	std::cout << "Time taken: " << t.elapsed() << " seconds\n";
+// Registers the sort, search and container paths with the size/thread sweep
+void registerSweeps()
+{
+	// Each call copies the unsorted input into a working buffer and sorts that, so the copy is part of the time.
+	// That's O(n) against the sort's O(n log n) (or O(n^2)), so it doesn't change the shape of the curve.
+	auto sortWorkload { [](std::size_t elements, auto sort) {
+		auto input { std::make_shared<const std::vector<int>>(makeRandomInput(elements)) };
+		auto work { std::make_shared<std::vector<int>>(elements) };
+		return Sweep::Workload { [input, work, sort]() {
+			std::copy(input->begin(), input->end(), work->begin());
+			sort(std::span<int> { *work });
+			Benchmark::doNotOptimize(*work);
+		}, elements };
+	} };
 
+	Sweep::add("sort/selection", [sortWorkload](std::size_t elements) {
+		return sortWorkload(elements, [](std::span<int> v) { sortArray(v); });
+	}, 16 * 1024); // O(n^2): anything bigger takes far too long
 
-	std::cout << "\n\nNow using std::sort from the standard library:\n";
+	Sweep::add("sort/std::ranges::sort", [sortWorkload](std::size_t elements) {
+		return sortWorkload(elements, [](std::span<int> v) { std::ranges::sort(v); });
+	});
 
-	std::array<int, g_arrayElements2> array2;
-	std::iota(array2.rbegin(), array2.rend(), 1); // fill the array with values 10000 to 1
+	// Each call does a fixed number of lookups, so ns/element here is ns per lookup
+	auto searchWorkload { [](std::size_t elements, auto search) {
+		constexpr std::size_t lookups { 1024 };
+		auto sorted { std::make_shared<std::vector<int>>(makeRandomInput(elements)) };
+		std::sort(sorted->begin(), sorted->end());
 
-	Timer t2;
+		auto targets { std::make_shared<std::vector<int>>(lookups) };
+		std::mt19937 mt { 7 };
+		for (auto& t : *targets)
+			t = (*sorted)[mt() % elements]; // always present, so every search runs to completion
 
-	std::ranges::sort(array2); // Since C++20
-	// If your compiler isn't C++20-capable
-	// std::sort(array.begin(), array.end());
+		return Sweep::Workload { [sorted, targets, search]() {
+			for (int t : *targets)
+			{
+				auto found { search(*sorted, t) };
+				Benchmark::doNotOptimize(found);
+			}
+		}, lookups };
+	} };
 
-	std::cout << "Time taken: " << t2.elapsed() << " seconds\n";
+	Sweep::add("search/binarySearch", [searchWorkload](std::size_t elements) {
+		return searchWorkload(elements, [](const std::vector<int>& v, int target) {
+			return binarySearch(v.data(), target, 0, static_cast<int>(v.size()) - 1);
+		});
+	});
+
+	Sweep::add("search/std::lower_bound", [searchWorkload](std::size_t elements) {
+		return searchWorkload(elements, [](const std::vector<int>& v, int target) {
+			return std::lower_bound(v.begin(), v.end(), target) - v.begin();
+		});
+	});
+
+	Sweep::add("container/IntArray::insertAtEnd", [](std::size_t elements) {
+		return Sweep::Workload { [elements]() {
+			IntArray array {};
+			for (int i { 0 }; i < static_cast<int>(elements); ++i)
+				array.insertAtEnd(i);
+			Benchmark::doNotOptimize(array);
+		}, elements };
+	}); // capacity doubles when full, so this is amortized O(1) per insert
+
+	// Same inserts with the capacity set up front, so the difference between the two curves is the cost of growing
+	Sweep::add("container/IntArray::reserve + insertAtEnd", [](std::size_t elements) {
+		return Sweep::Workload { [elements]() {
+			IntArray array {};
+			array.reserve(static_cast<int>(elements));
+			for (int i { 0 }; i < static_cast<int>(elements); ++i)
+				array.insertAtEnd(i);
+			Benchmark::doNotOptimize(array);
+		}, elements };
+	});
+
+	Sweep::add("container/std::vector::push_back", [](std::size_t elements) {
+		return Sweep::Workload { [elements]() {
+			std::vector<int> v {};
+			for (int i { 0 }; i < static_cast<int>(elements); ++i)
+				v.push_back(i);
+			Benchmark::doNotOptimize(v);
+		}, elements };
+	});
+}
+
+// Usage: Timing_Your_Code [--json] [--perf] [--save] [--compare] [--store <file>] [--pin <cpu>] [--cold] [--mlock]
+//   --save     append this run's samples to the baseline store
+//   --compare  compare this run against the stored baseline (on stderr with --json); exits with 1 if anything got
+//              significantly slower
+//   --pin      run on the given CPU only
+//   --cold     flush the caches before every sample (default is hot: caches warm from the previous iteration)
+//   --mlock    lock the process's memory into RAM
+//   --sweep [prefix]     instead of the benchmarks above, run the size/thread sweep (optionally only for benchmarks
+//                        whose names start with prefix) and print CSV
+//   --max-elements <n>   largest input size for --sweep (default 4M elements)
+//   --threads <n>        run --sweep with exactly n threads (default 1, 2, 4, ... up to the number of cores)
+int main(int argc, char* argv[])
+{
+	bool json { false };
+	bool perf { false };
+	bool save { false };
+	bool compare { false };
+	std::string_view storePath { "benchmark_baselines.txt" };
+	Benchmark::Options options {};
+	int pinCpu { -1 };
+	bool lockMemory { false };
+	bool sweep { false };
+	std::string_view sweepFilter {};
+	std::size_t maxElements { 4 * 1024 * 1024 };
+	unsigned int threads { 0 };
+	for (int i { 1 }; i < argc; ++i)
+	{
+		std::string_view arg { argv[i] };
+		if (arg == "--json")
+			json = true;
+		else if (arg == "--perf")
+			perf = true;
+		else if (arg == "--save")
+			save = true;
+		else if (arg == "--compare")
+			compare = true;
+		else if (arg == "--store" && i + 1 < argc)
+			storePath = argv[++i];
+		else if (arg == "--pin" && i + 1 < argc)
+			pinCpu = std::atoi(argv[++i]);
+		else if (arg == "--cold")
+			options.cacheMode = Benchmark::CacheMode::cold;
+		else if (arg == "--mlock")
+			lockMemory = true;
+		else if (arg == "--sweep")
+		{
+			sweep = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				sweepFilter = argv[++i];
+		}
+		else if (arg == "--max-elements" && i + 1 < argc)
+			maxElements = static_cast<std::size_t>(std::atoll(argv[++i]));
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+	}
+
+	// Set up the environment before anything is measured.  Problems are reported on stderr (so --json output stays
+	// valid), and we carry on with whatever we could get.
+	if (pinCpu >= 0 && !BenchEnvironment::pinToCpu(pinCpu))
+		std::cerr << "Could not pin to CPU " << pinCpu << '\n';
+	if (lockMemory && !BenchEnvironment::lockMemory())
+		std::cerr << "Could not lock memory (try raising ulimit -l)\n";
+
+	if (perf)
+	{
+		runPerfCounters();
+		return 0;
+	}
+
+	if (sweep)
+	{
+		registerSweeps();
+
+		Sweep::Options sweepOptions {};
+		sweepOptions.sizes = Sweep::defaultSizes(maxElements);
+		sweepOptions.threads = (threads > 0) ? std::vector<unsigned int> { threads } : Sweep::defaultThreadCounts();
+		Sweep::run(std::cout, sweepOptions, sweepFilter);
+		return 0;
+	}
+
+	std::vector<Benchmark::Result> results { runSortBenchmarks(options) };
+	for (auto& r : runSearchBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runContainerBenchmarks(options))
+		results.push_back(r);
+	for (auto& r : runClockBenchmarks(options))
+		results.push_back(r);
+
+	if (json)
+	{
+		Benchmark::printJson(std::cout, results);
+	}
+	else
+	{
+		Benchmark::printText(std::cout, results);
+
+		if (TscClock::usingTsc())
+			std::cout << "\nTscClock: invariant TSC at " << TscClock::frequency() / 1e9 << " GHz\n";
+		else
+			std::cout << "\nTscClock: no invariant TSC, falling back to steady_clock\n";
+	}
+
+	const Baseline::Store store { storePath };
+	int regressions { 0 };
+
+	if (compare)
+	{
+		// With --json, stdout has to stay a single JSON document, so the comparison goes to stderr
+		std::ostream& out { json ? std::cerr : std::cout };
+		out << '\n';
+		regressions = compareWithBaseline(out, store, results);
+	}
+
+	if (save)
+	{
+		const std::string machine { Baseline::machineFingerprint() };
+		for (const auto& r : results)
+			store.save(r, Baseline::gitRevision, machine);
+	}
 
-	return 0;
+	return (regressions > 0) ? 1 : 0;
 }
 
 /*
@@ -1,21 +1,40 @@
 #ifndef INTARRAY_H
 #define INTARRAY_H
 
-#include <algorithm> // for std::copy_n
+#include <algorithm> // for std::copy_n, std::copy_backward, std::copy
 #include <cassert> // for assert()
 #include <cstddef> // for std::size_t
+#include <limits> // for std::numeric_limits
+#include <utility> // for std::exchange, std::swap
 
+// IntArray keeps a capacity separate from its length, like std::vector: m_data has room for m_capacity elements, of
+// which the first m_length are in use.  When an insert needs more room, the capacity is doubled rather than grown by
+// one, so n calls to insertAtEnd only reallocate about log2(n) times (amortized O(1) each, instead of O(n) each).
 class IntArray
 {
 private:
     int m_length{};
+    int m_capacity{};
     int* m_data{};
 
+    // Moves the elements into a new buffer with room for newCapacity elements (which must hold all of them)
+    void reallocateStorage(int newCapacity)
+    {
+        assert(newCapacity >= m_length);
+
+        int* data{ (newCapacity > 0) ? new int[static_cast<std::size_t>(newCapacity)] : nullptr };
+        std::copy_n(m_data, m_length, data);
+
+        delete[] m_data;
+        m_data = data;
+        m_capacity = newCapacity;
+    }
+
 public:
     IntArray() = default;
 
     IntArray(int length):
-        m_length{ length }
+        m_length{ length }, m_capacity{ length }
     {
         assert(length >= 0);
 
@@ -47,6 +66,39 @@ public:
         return *this;
     }
 
+    // Moving just takes over the other array's memory (and leaves it empty), so returning an IntArray from a function
+    // or storing one in a std::vector is O(1) instead of a copy of every element.  These are noexcept so that
+    // std::vector will move our arrays, rather than copy them, when it grows.
+    IntArray(IntArray&& a) noexcept
+        : m_length{ std::exchange(a.m_length, 0) }
+        , m_capacity{ std::exchange(a.m_capacity, 0) }
+        , m_data{ std::exchange(a.m_data, nullptr) }
+    {
+    }
+
+    IntArray& operator=(IntArray&& a) noexcept
+    {
+        // Self-assignment check
+        if (&a == this)
+            return *this;
+
+        delete[] m_data;
+        m_length = std::exchange(a.m_length, 0);
+        m_capacity = std::exchange(a.m_capacity, 0);
+        m_data = std::exchange(a.m_data, nullptr);
+
+        return *this;
+    }
+
+    void swap(IntArray& a) noexcept
+    {
+        std::swap(m_length, a.m_length);
+        std::swap(m_capacity, a.m_capacity);
+        std::swap(m_data, a.m_data);
+    }
+
+    friend void swap(IntArray& a, IntArray& b) noexcept { a.swap(b); }
+
     void erase()
     {
         delete[] m_data;
@@ -54,6 +106,7 @@ public:
         // be left pointing at deallocated memory!
         m_data = nullptr;
         m_length = 0;
+        m_capacity = 0;
     }
 
     int& operator[](int index)
@@ -66,7 +119,14 @@ public:
     // reallocate resizes the array.  Any existing elements will be destroyed.  This function operates quickly.
     void reallocate(int newLength)
     {
-        // First we delete any existing elements
+        // If the elements fit in the memory we already have, we can just reuse it
+        if (newLength > 0 && newLength <= m_capacity)
+        {
+            m_length = newLength;
+            return;
+        }
+
+        // Otherwise we delete any existing elements
         erase();
 
         // If our array is going to be empty now, return here
@@ -76,6 +136,22 @@ public:
         // Then we have to allocate new elements
         m_data = new int[static_cast<std::size_t>(newLength)];
         m_length = newLength;
+        m_capacity = newLength;
+    }
+
+    // Makes room for at least newCapacity elements without changing the length, so that many insertions in a row
+    // (e.g. loading a million values) only allocate once.  Never shrinks the array.
+    void reserve(int newCapacity)
+    {
+        if (newCapacity > m_capacity)
+            reallocateStorage(newCapacity);
+    }
+
+    // Gives back any memory the elements aren't using
+    void shrink_to_fit()
+    {
+        if (m_capacity > m_length)
+            reallocateStorage(m_length);
     }
 
     // resize resizes the array.  Any existing elements will be kept.  This function operates slowly.
@@ -92,6 +168,13 @@ public:
             return;
         }
 
+        // If the new elements fit in the memory we already have (or we're shrinking), there's nothing to copy
+        if (newLength <= m_capacity)
+        {
+            m_length = newLength;
+            return;
+        }
+
         // Now we can assume newLength is at least 1 element.  This algorithm
         // works as follows: First we are going to allocate a new array.  Then we
         // are going to copy elements from the existing array to the new array.
@@ -118,6 +201,7 @@ public:
         // data was dynamically allocated, it won't be destroyed when it goes out of scope.
         m_data = data;
         m_length = newLength;
+        m_capacity = newLength;
     }
 
     void insertBefore(int value, int index)
@@ -125,21 +209,18 @@ public:
         // Sanity check our index value
         assert(index >= 0 && index <= m_length);
 
-        // First create a new array one element larger than the old array
-        int* data{ new int[static_cast<std::size_t>(m_length+1)] };
-
-        // Copy all of the elements up to the index
-        std::copy_n(m_data, index, data);
-
-        // Insert our new element into the new array
-        data[index] = value;
+        // If the array is full, double its capacity (so this only happens once every m_length insertions)
+        if (m_length == m_capacity)
+        {
+            assert(m_capacity <= std::numeric_limits<int>::max() / 2);
+            reallocateStorage((m_capacity > 0) ? m_capacity * 2 : 1);
+        }
 
-        // Copy all of the values after the inserted element
-        std::copy_n(m_data + index, m_length - index, data + index + 1);
+        // Shift all of the values from the index onwards up by one, working from the end so nothing is overwritten
+        std::copy_backward(m_data + index, m_data + m_length, m_data + m_length + 1);
 
-        // Finally, delete the old array, and use the new array instead
-        delete[] m_data;
-        m_data = data;
+        // Insert our new element into the gap
+        m_data[index] = value;
         ++m_length;
     }
 
@@ -148,25 +229,9 @@ public:
         // Sanity check our index value
         assert(index >= 0 && index < m_length);
 
-        // If this is the last remaining element in the array, set the array to empty and bail out
-        if (m_length == 1)
-        {
-            erase();
-            return;
-        }
-
-        // First create a new array one element smaller than the old array
-        int* data{ new int[static_cast<std::size_t>(m_length-1)] };
-
-        // Copy all of the elements up to the index
-        std::copy_n(m_data, index, data);
-
-        // Copy all of the values after the removed element
-        std::copy_n(m_data + index + 1, m_length - index - 1, data + index);
-
-        // Finally, delete the old array, and use the new array instead
-        delete[] m_data;
-        m_data = data;
+        // Shift all of the values after the removed element down by one.  The memory is kept for the next insertion
+        // (call shrink_to_fit to give it back).
+        std::copy(m_data + index + 1, m_data + m_length, m_data + index);
         --m_length;
     }
 
@@ -175,6 +240,7 @@ public:
     void insertAtEnd(int value) { insertBefore(value, m_length); }
 
     int getLength() const { return m_length; }
+    int capacity() const { return m_capacity; }
 };
 
 #endif
\ No newline at end of file
@@ -19,8 +19,23 @@ similar to std::vector<int>.
  */
 
 #include <iostream>
+#include <utility> // for std::move
+#include <vector>
+#include "Profiler.h" // configure with -DENABLE_ALLOCATION_TRACKING=ON to see how often IntArray allocates
 #include "IntArray.h"
 
+// Returns an array holding 1 through length.  The array is moved (or constructed in place) into the caller's
+// variable, not copied.
+IntArray makeSequence(int length)
+{
+	IntArray sequence {};
+	sequence.reserve(length);
+	for (int i{ 1 }; i <= length; ++i)
+		sequence.insertAtEnd(i);
+
+	return sequence;
+}
+
 int main()
 {
 	// Declare an array with 10 elements
@@ -31,27 +46,72 @@ int main()
 		array[i] = i+1;
 
 	// Resize the array to 8 elements
-	array.resize(8);
+	{
+		PROFILE_SCOPE("IntArray::resize");
+		array.resize(8);
+	}
 
 	// Insert the number 20 before element with index 5
-	array.insertBefore(20, 5);
+	{
+		PROFILE_SCOPE("IntArray::insertBefore");
+		array.insertBefore(20, 5);
+	}
 
 	// Remove the element with index 3
-	array.remove(3);
+	{
+		PROFILE_SCOPE("IntArray::remove");
+		array.remove(3);
+	}
 
 	// Add 30 and 40 to the end and beginning
-	array.insertAtEnd(30);
-	array.insertAtBeginning(40);
+	{
+		PROFILE_SCOPE("IntArray::insertBefore");
+		array.insertAtEnd(30);
+		array.insertAtBeginning(40);
+	}
 
 	// A few more tests to ensure copy constructing / assigning arrays
 	// doesn't break things
 	{
+		PROFILE_SCOPE("IntArray copy");
 		IntArray b{ array };
 		b = array;
 		b = b;
 		array = array;
 	}
 
+	// Appending one element at a time used to reallocate on every call.  Now the capacity doubles whenever it runs
+	// out, so this only allocates 11 times...
+	{
+		PROFILE_SCOPE("IntArray::insertAtEnd x1000");
+		IntArray appended {};
+		for (int i{ 0 }; i < 1000; ++i)
+			appended.insertAtEnd(i);
+	}
+
+	// ...and if we know how many elements are coming, reserve lets us allocate just once
+	{
+		PROFILE_SCOPE("IntArray::reserve + insertAtEnd x1000");
+		IntArray appended {};
+		appended.reserve(1000);
+		for (int i{ 0 }; i < 1000; ++i)
+			appended.insertAtEnd(i);
+	}
+
+	// Moving an array only hands over its memory, so the only allocations here are the arrays' own (and the vector's)
+	{
+		PROFILE_SCOPE("IntArray move");
+		IntArray sequence { makeSequence(1000) };
+
+		std::vector<IntArray> arrays {};
+		arrays.push_back(std::move(sequence));
+		arrays.push_back(makeSequence(1000));
+		arrays.push_back(makeSequence(1000)); // the vector grows here, moving (not copying) the first two arrays
+
+		swap(arrays[0], arrays[2]);
+		sequence = std::move(arrays[1]);
+	}
+
 	// Print out all the numbers
 	for (int i{ 0 }; i<array.getLength(); ++i)
 		std::cout << array[i] << ' ';
@@ -172,11 +172,14 @@ Using the IntArray class above, implement an overloaded assignment operator that
 #include <cassert>   // for assert()
 #include <initializer_list> // for std::initializer_list
 #include <iostream>
+#include <utility> // for std::exchange, std::move, std::swap
+#include <vector>
 
 class IntArray
 {
 private:
  int m_length {};
+ int m_capacity {}; // how many elements m_data has room for (at least m_length)
  int* m_data {};
 
 public:
@@ -184,6 +187,7 @@ public:
 
  IntArray(int length)
   : m_length{ length }
+ , m_capacity{ length }
  , m_data{ new int[static_cast<std::size_t>(length)] {} }
  {
 
@@ -205,16 +209,53 @@ public:
  IntArray(const IntArray&) = delete; // to avoid shallow copies
  IntArray& operator=(const IntArray& list) = delete; // to avoid shallow copies
 
- IntArray& operator=(std::initializer_list<int> list)
+ // Moving is fine though: the new array takes over the old one's memory, and the old one is left empty, so there's
+ // still only one owner.  This lets an IntArray be returned from a function or kept in a std::vector, in O(1) rather
+ // than copying every element.  noexcept, so std::vector moves our arrays (instead of trying to copy them) as it grows.
+ IntArray(IntArray&& a) noexcept
+  : m_length{ std::exchange(a.m_length, 0) }
+ , m_capacity{ std::exchange(a.m_capacity, 0) }
+ , m_data{ std::exchange(a.m_data, nullptr) }
  {
-  // If the new list is a different size, reallocate it
+
+ }
+
+ IntArray& operator=(IntArray&& a) noexcept
+ {
+  // Self-assignment check
+  if (&a == this)
+   return *this;
+
+  delete[] m_data;
+  m_length = std::exchange(a.m_length, 0);
+  m_capacity = std::exchange(a.m_capacity, 0);
+  m_data = std::exchange(a.m_data, nullptr);
+
+  return *this;
+ }
+
+ void swap(IntArray& a) noexcept
+ {
+  std::swap(m_length, a.m_length);
+  std::swap(m_capacity, a.m_capacity);
+  std::swap(m_data, a.m_data);
+ }
+
+ friend void swap(IntArray& a, IntArray& b) noexcept { a.swap(b); }
+
+ // The & stops a list being assigned to a temporary (IntArray{} = { 1, 2, 3 }), where the reference we return would
+ // dangle once the temporary dies at the end of the full expression
+ IntArray& operator=(std::initializer_list<int> list) &
+ {
+  // Only reallocate if the new list doesn't fit in the memory we already have
   int length { static_cast<int>(list.size()) };
-  if (length != m_length)
+  if (length > m_capacity)
   {
    delete[] m_data;
-   m_length = length;
    m_data = new int[list.size()]{};
+   m_capacity = length;
   }
+  m_length = length;
 
   // Now initialize our array from the list
   std::copy(list.begin(), list.end(), m_data);
@@ -229,8 +270,20 @@ public:
  }
 
  int getLength() const { return m_length; }
+ int capacity() const { return m_capacity; }
 };
 
+// Returns an array counting down from length to 1.  IntArray can't be copied, so before it had a move constructor it
+// couldn't be returned by name like this at all.
+IntArray makeCountdown(int length)
+{
+ IntArray countdown(length);
+ for (int count{ 0 }; count < length; ++count)
+  countdown[count] = length - count;
+
+ return countdown;
+}
+
 int main()
 {
  IntArray array { 5, 4, 3, 2, 1 }; // initializer list
@@ -246,5 +299,28 @@ int main()
 
  std::cout << '\n';
 
+ // A shorter list fits in the memory we already have, so this doesn't reallocate
+ array = { 2, 4, 6 };
+
+ for (int count{ 0 }; count < array.getLength(); ++count)
+  std::cout << array[count] << ' ';
+
+ std::cout << "(capacity " << array.capacity() << ")\n";
+
+ // Move-only arrays can be returned from functions and stored in a std::vector
+ std::vector<IntArray> arrays {};
+ arrays.push_back(makeCountdown(3));
+ arrays.push_back(std::move(array)); // array is left empty
+ arrays.push_back(IntArray{ 7, 8, 9 });
+ swap(arrays[0], arrays[2]);
+
+ for (auto& a : arrays)
+ {
+  for (int count{ 0 }; count < a.getLength(); ++count)
+   std::cout << a[count] << ' ';
+
+  std::cout << '\n';
+ }
+
  return 0;
 }
\ No newline at end of file